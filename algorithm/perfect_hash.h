@@ -0,0 +1,208 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace algo {
+    namespace hash {
+        /*Finalizer of splitmix64: a bijective 64-bit mixer*/
+        inline constexpr uint64_t mix(uint64_t value) noexcept {
+            value ^= value >> 30;
+            value *= 0xBF58476D1CE4E5B9ULL;
+            value ^= value >> 27;
+            value *= 0x94D049BB133111EBULL;
+            value ^= value >> 31;
+            return value;
+        }
+
+        /*Seeded 64-bit string hash (8 bytes per step)*/
+        inline uint64_t hash_string(std::string_view str, uint64_t seed) noexcept {
+            constexpr uint64_t multiplier{ 0x9E3779B97F4A7C15ULL };
+            uint64_t result{ seed ^ (str.length() * multiplier) };
+            const char* data{ str.data() };
+            size_t length{ str.length() };
+            for (; length >= sizeof(uint64_t); data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+                uint64_t word;
+                std::memcpy(&word, data, sizeof(uint64_t));
+                result = std::rotl((result ^ word) * multiplier, 29);
+            }
+            if (length) {
+                uint64_t word{ 0 };
+                std::memcpy(&word, data, length);
+                result = std::rotl((result ^ word) * multiplier, 29);
+            }
+            return mix(result);
+        }
+
+        /*Minimal perfect hash over a fixed set of unique keys (hash and displace, CHD style).
+        Keys are spread over buckets (two keys per bucket on average), then the buckets are placed
+        from the largest one: a bucket stores the pilot that moves all its keys to free slots.
+        Single-key buckets take the remaining slots directly. Key i gets the id i.
+        The keys are not copied: they must outlive the index*/
+        template <class Id = uint32_t>
+        class PerfectHashIndex {
+        public:
+            PerfectHashIndex() = default;
+            explicit PerfectHashIndex(std::span<const std::string_view> keys_) {
+                for (uint64_t seed = 0; seed < max_seed_attempts; ++seed) {
+                    if (try_build(keys_, seed)) {
+                        return;
+                    }
+                }
+                throw std::invalid_argument("Perfect hash can't be built (are the keys unique?)");
+            }
+
+            size_t Size() const noexcept {
+                return keys.size();
+            }
+
+            std::optional<Id> Find(std::string_view key) const noexcept {
+                if (keys.empty()) {
+                    return std::nullopt;
+                }
+                const uint64_t key_hash{ hash_string(key, seed) };
+                const size_t slot{ get_slot(key_hash) };
+                if (hashes[slot] != key_hash || keys[slot] != key) {    //The cached hash rejects almost all the foreign keys
+                    return std::nullopt;
+                }
+                return ids[slot];
+            }
+
+            Id At(std::string_view key) const {
+                if (auto id = Find(key)) {
+                    return *id;
+                }
+                throw std::out_of_range("Key is not in the perfect hash index");
+            }
+
+        private:
+            static constexpr uint64_t max_seed_attempts{ 64 };
+            static constexpr uint32_t max_pilot{ 1u << 20 };
+            static constexpr uint32_t direct_slot_flag{ 1u << 31 };     //Pilot of a single-key bucket is the slot itself
+
+            size_t get_bucket(uint64_t key_hash) const noexcept {
+                return static_cast<size_t>((key_hash >> 32) % pilots.size());
+            }
+            size_t get_slot(uint64_t key_hash, uint32_t pilot) const noexcept {
+                return static_cast<size_t>(mix(key_hash ^ mix(pilot)) % keys.size());
+            }
+            size_t get_slot(uint64_t key_hash) const noexcept {
+                const uint32_t pilot{ pilots[get_bucket(key_hash)] };
+                return pilot & direct_slot_flag ? pilot & ~direct_slot_flag : get_slot(key_hash, pilot);
+            }
+
+            bool try_build(std::span<const std::string_view> keys_, uint64_t seed_) {
+                const size_t key_count{ keys_.size() };
+                seed = seed_;
+                keys.assign(key_count, std::string_view{});
+                hashes.assign(key_count, 0);
+                ids.assign(key_count, Id{ 0 });
+                pilots.assign(key_count / 2 + 1, 0);
+                if (key_count == 0) {
+                    return true;
+                }
+
+                /*Keys grouped by buckets (counting sort)*/
+                std::vector<uint64_t> key_hashes(key_count);
+                std::vector<uint32_t> bucket_offsets(pilots.size() + 1, 0);
+                for (size_t key = 0; key < key_count; ++key) {
+                    key_hashes[key] = hash_string(keys_[key], seed);
+                    ++bucket_offsets[get_bucket(key_hashes[key]) + 1];
+                }
+                std::partial_sum(bucket_offsets.begin(), bucket_offsets.end(), bucket_offsets.begin());
+                std::vector<uint32_t> bucket_keys(key_count), cursor(bucket_offsets.begin(), std::prev(bucket_offsets.end()));
+                for (uint32_t key = 0; key < key_count; ++key) {
+                    bucket_keys[cursor[get_bucket(key_hashes[key])]++] = key;
+                }
+
+                std::vector<uint32_t> bucket_order(pilots.size());
+                std::iota(bucket_order.begin(), bucket_order.end(), 0u);
+                std::stable_sort(bucket_order.begin(), bucket_order.end(), [&bucket_offsets](uint32_t lhs, uint32_t rhs) {
+                    return bucket_offsets[lhs + 1] - bucket_offsets[lhs] > bucket_offsets[rhs + 1] - bucket_offsets[rhs];
+                    });
+
+                std::vector<bool> is_taken(key_count, false);
+                std::vector<size_t> bucket_slots;
+                size_t free_slot{ 0 };
+                for (const uint32_t bucket : bucket_order) {
+                    const std::span<const uint32_t> members(
+                        bucket_keys.data() + bucket_offsets[bucket],
+                        bucket_offsets[bucket + 1] - bucket_offsets[bucket]
+                    );
+                    if (members.empty()) {
+                        break;                                          //Buckets are sorted by size
+                    }
+                    if (members.size() == 1) {
+                        for (; is_taken[free_slot]; ++free_slot);
+                        pilots[bucket] = static_cast<uint32_t>(free_slot) | direct_slot_flag;
+                        place(members.front(), free_slot, keys_, key_hashes, &is_taken);
+                        continue;
+                    }
+                    if (!place_bucket(bucket, members, keys_, key_hashes, &is_taken, &bucket_slots)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool place_bucket(
+                uint32_t bucket,
+                std::span<const uint32_t> members,
+                std::span<const std::string_view> keys_,
+                const std::vector<uint64_t>& key_hashes,
+                std::vector<bool>* is_taken,
+                std::vector<size_t>* bucket_slots
+            ) {
+                for (uint32_t pilot = 0; pilot < max_pilot; ++pilot) {
+                    bucket_slots->clear();
+                    bool fits{ true };
+                    for (const uint32_t key : members) {
+                        const size_t slot{ get_slot(key_hashes[key], pilot) };
+                        if ((*is_taken)[slot] || std::find(bucket_slots->begin(), bucket_slots->end(), slot) != bucket_slots->end()) {
+                            fits = false;
+                            break;
+                        }
+                        bucket_slots->push_back(slot);
+                    }
+                    if (fits) {
+                        pilots[bucket] = pilot;
+                        for (size_t idx = 0; idx < members.size(); ++idx) {
+                            place(members[idx], (*bucket_slots)[idx], keys_, key_hashes, is_taken);
+                        }
+                        return true;
+                    }
+                }
+                return false;                                           //Equal hashes: another seed is required
+            }
+
+            void place(
+                uint32_t key,
+                size_t slot,
+                std::span<const std::string_view> keys_,
+                const std::vector<uint64_t>& key_hashes,
+                std::vector<bool>* is_taken
+            ) {
+                (*is_taken)[slot] = true;
+                keys[slot] = keys_[key];
+                hashes[slot] = key_hashes[key];
+                ids[slot] = static_cast<Id>(key);
+            }
+
+        private:
+            uint64_t seed{ 0 };
+            std::vector<uint32_t> pilots;
+
+            /*Slot-indexed arrays*/
+            std::vector<std::string_view> keys;
+            std::vector<uint64_t> hashes;
+            std::vector<Id> ids;
+        };
+    }
+}
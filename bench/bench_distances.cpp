@@ -0,0 +1,58 @@
+#include "bench_runner.h"
+#include "earth.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/*Geographic lengths of route segments: calc_distance per pair against calc_distances over a TrigTable
+(the table is built once per catalog and is not timed):
+DistancesBench [stop count] [segment count] [runs]*/
+int main(int argc, char* argv[]) {
+	const size_t stop_count{ bench::GetArgument(argc, argv, 1, 20000) };
+	const size_t segment_count{ bench::GetArgument(argc, argv, 2, 1000000) };
+	const size_t runs{ bench::GetArgument(argc, argv, 3, 5) };
+	mt19937 random(22);
+	uniform_real_distribution<double> latitude(55.5, 55.8), longitude(37.3, 37.7);
+	vector<geographic::Coordinates> coordinates(stop_count);
+	for (auto& point : coordinates) {
+		point = { latitude(random), longitude(random) };
+	}
+	vector<uint32_t> from(segment_count), to(segment_count);
+	for (size_t segment = 0; segment < segment_count; ++segment) {
+		from[segment] = static_cast<uint32_t>(random() % stop_count);
+		to[segment] = static_cast<uint32_t>(random() % stop_count);
+	}
+#ifdef __AVX2__
+	cout << "calc_distances: AVX2" << endl;
+#else
+	cout << "calc_distances: scalar" << endl;
+#endif
+
+	vector<double> per_pair(segment_count), batched(segment_count);
+	const auto per_pair_time{ bench::Measure(runs, [&]() {
+		for (size_t segment = 0; segment < segment_count; ++segment) {
+			per_pair[segment] = geographic::calc_distance(coordinates[from[segment]], coordinates[to[segment]]);
+		}
+		bench::KeepAlive(per_pair);
+		}) };
+	bench::Report("calc_distance per pair", per_pair_time);
+
+	geographic::TrigTable table;
+	table.Assign(coordinates);
+	const auto batched_time{ bench::Measure(runs, [&]() {
+		geographic::calc_distances(table, from, to, batched);
+		bench::KeepAlive(batched);
+		}) };
+	bench::Report("calc_distances over TrigTable", batched_time, bench::Speedup(per_pair_time, batched_time));
+
+	/*acos is ill-conditioned for close points: both forms round differently there, so the difference is absolute*/
+	double max_difference{ 0 };
+	for (size_t segment = 0; segment < segment_count; ++segment) {
+		max_difference = max(max_difference, abs(batched[segment] - per_pair[segment]));
+	}
+	cout << "Max difference: " << max_difference << " m" << endl;
+	return 0;
+}
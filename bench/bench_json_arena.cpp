@@ -0,0 +1,69 @@
+#include "bench_runner.h"
+#include "network_generator.h"
+
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+using namespace std;
+
+namespace {
+	struct Timings {
+		bench::Duration load{ bench::Duration::max() };
+		bench::Duration destroy{ bench::Duration::max() };
+	};
+
+	/*Best load and destroy times: the document is destroyed right after it is loaded*/
+	Timings measure(size_t runs, const function<Json::Document()>& load) {
+		Timings timings;
+		for (size_t run = 0; run < runs; ++run) {
+			optional<Json::Document> document;
+			timings.load = min(timings.load, bench::Measure(1, [&]() { document.emplace(load()); }));
+			timings.destroy = min(timings.destroy, bench::Measure(1, [&]() { document.reset(); }));
+		}
+		return timings;
+	}
+
+	/*The same SAX parser builds the tree with the given memory*/
+	Json::Node build(string_view input, pmr::memory_resource* resource) {
+		Json::Builder builder(resource);
+		Json::Parse(input, builder);
+		return builder.Extract();
+	}
+
+	void report(string_view name, const Timings& timings, const Timings& reference) {
+		bench::Report(string(name) + ": load", timings.load, bench::Speedup(reference.load, timings.load));
+		bench::Report(string(name) + ": destroy", timings.destroy, bench::Speedup(reference.destroy, timings.destroy));
+	}
+}
+
+/*Load and destroy times of JSON trees allocated node by node and from one arena:
+JsonArenaBench [stop count] [runs]*/
+int main(int argc, char* argv[]) {
+	const generator::Parameters parameters{
+		.stop_count = bench::GetArgument(argc, argv, 1, 50000),
+		.bus_count = bench::GetArgument(argc, argv, 1, 50000) / 10,
+		.max_route_stops = 30
+	};
+	const size_t runs{ bench::GetArgument(argc, argv, 2, 10) };
+	const generator::StatRequests stat{ .buses = parameters.bus_count, .stops = parameters.stop_count, .routes = parameters.stop_count };
+	const auto input{ generator::MakeInput(generator::MakeNetwork(parameters), stat, Json::Format::COMPACT) };
+	cout << "Input: " << input.size() << " bytes" << endl;
+
+	const auto heap{ measure(runs, [&input]() {
+		return Json::Document(build(input, pmr::new_delete_resource()));
+		}) };
+	report("Builder, new/delete", heap, heap);
+
+	const auto arena{ measure(runs, [&input]() {
+		auto memory{ make_unique<Json::Arena>(input.size()) };
+		auto root{ build(input, memory.get()) };
+		return Json::Document(move(memory), move(root));
+		}) };
+	report("Builder, arena", arena, heap);
+
+	report("Json::Load", measure(runs, [&input]() { return Json::Load(input); }), heap);
+	report("Json::LoadInPlace", measure(runs, [&input]() { return Json::LoadInPlace(input); }), heap);
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "bench_runner.h"
+#include "network_generator.h"
+#include "json_scanner.h"
+
+#include <cctype>
+
+using namespace std;
+
+namespace {
+	/*Per-char predicates, as Json::Load used them before the scanner*/
+	struct PerChar {
+		static size_t SkipService(string_view str) {
+			size_t pos{ 0 };
+			for (; pos < str.length() && (isspace(static_cast<unsigned char>(str[pos])) || str[pos] == ',' || str[pos] == ':'); ++pos);
+			return pos;
+		}
+		static size_t FindQuote(string_view str) {
+			return min(str.find_first_of('\"'), str.length());
+		}
+		static size_t CountDigits(string_view str) {
+			size_t pos{ 0 };
+			for (; pos < str.length() && isdigit(static_cast<unsigned char>(str[pos])); ++pos);
+			return pos;
+		}
+	};
+
+	struct Vectorized {
+		static size_t SkipService(string_view str) noexcept {
+			return Json::scanner::SkipService(str);
+		}
+		static size_t FindQuote(string_view str) noexcept {
+			return Json::scanner::FindQuote(str);
+		}
+		static size_t CountDigits(string_view str) noexcept {
+			return Json::scanner::CountDigits(str);
+		}
+	};
+
+	/*The scanning done by the loader without building the tree: service symbols, strings and digit runs*/
+	template <typename Scanner>
+	size_t tokenize(string_view input) {
+		size_t tokens{ 0 };
+		size_t pos{ 0 };
+		while (pos < input.length()) {
+			pos += Scanner::SkipService(input.substr(pos));
+			if (pos == input.length()) {
+				break;
+			}
+			if (input[pos] == '\"') {
+				pos += Scanner::FindQuote(input.substr(pos + 1)) + 2;
+			}
+			else if (isdigit(static_cast<unsigned char>(input[pos]))) {
+				pos += Scanner::CountDigits(input.substr(pos));
+			}
+			else {
+				++pos;
+			}
+			++tokens;
+		}
+		return tokens;
+	}
+
+	/*Pretty input as formatted by the common tools: 4 spaces per nesting level*/
+	string indent(string_view pretty) {
+		string indented;
+		indented.reserve(pretty.size() * 2);
+		size_t depth{ 0 };
+		bool in_string{ false };
+		for (size_t pos = 0; pos < pretty.size(); ++pos) {
+			const char ch{ pretty[pos] };
+			if (ch == '\"') {
+				in_string = !in_string;
+			}
+			else if (!in_string && (ch == '[' || ch == '{')) {
+				++depth;
+			}
+			else if (!in_string && (ch == ']' || ch == '}')) {
+				--depth;
+			}
+			indented.push_back(ch);
+			if (ch == '\n' && pos + 1 < pretty.size()) {
+				const char next{ pretty[pos + 1] };
+				indented.append(4 * (depth - (next == ']' || next == '}' ? 1 : 0)), ' ');
+			}
+		}
+		return indented;
+	}
+
+	void run(string_view format_name, const string& input, size_t runs) {
+		cout << "--- " << format_name << ": " << input.size() << " bytes" << endl;
+
+		const auto per_char{ bench::Measure(runs, [&input]() { bench::KeepAlive(tokenize<PerChar>(input)); }) };
+		bench::Report("tokenize per char", per_char, bench::Throughput(input.size(), per_char));
+		const auto vectorized{ bench::Measure(runs, [&input]() { bench::KeepAlive(tokenize<Vectorized>(input)); }) };
+		bench::Report("tokenize with the scanner", vectorized,
+			bench::Throughput(input.size(), vectorized) + ", " + bench::Speedup(per_char, vectorized));
+
+		for (const auto& [name, parsing] : { pair{ "Load", Json::Parsing::SEQUENTIAL }, pair{ "Load (parallel)", Json::Parsing::PARALLEL } }) {
+			const auto load{ bench::Measure(runs, [&input, parsing = parsing]() { bench::KeepAlive(Json::Load(input, parsing)); }) };
+			bench::Report(name, load, bench::Throughput(input.size(), load));
+		}
+		const auto in_place{ bench::Measure(runs, [&input]() { bench::KeepAlive(Json::LoadInPlace(input)); }) };
+		bench::Report("LoadInPlace", in_place, bench::Throughput(input.size(), in_place));
+	}
+}
+
+/*Json::Load throughput over a generated input document:
+JsonLoadBench [stop count] [runs]*/
+int main(int argc, char* argv[]) {
+	const generator::Parameters parameters{
+		.stop_count = bench::GetArgument(argc, argv, 1, 50000),
+		.bus_count = bench::GetArgument(argc, argv, 1, 50000) / 10,
+		.max_route_stops = 30
+	};
+	const size_t runs{ bench::GetArgument(argc, argv, 2, 5) };
+	const auto network{ generator::MakeNetwork(parameters) };
+	const generator::StatRequests stat{ .buses = parameters.bus_count, .stops = parameters.stop_count, .routes = parameters.stop_count };
+
+#ifdef JSON_SCANNER_AVX2
+	cout << "Scanner: AVX2" << endl;
+#elif defined(JSON_SCANNER_SSE2)
+	cout << "Scanner: SSE2" << endl;
+#else
+	cout << "Scanner: scalar" << endl;
+#endif
+	const auto pretty{ generator::MakeInput(network, stat, Json::Format::PRETTY) };
+	run("pretty", pretty, runs);
+	run("indented", indent(pretty), runs);
+	run("compact", generator::MakeInput(network, stat, Json::Format::COMPACT), runs);
+	return 0;
+}
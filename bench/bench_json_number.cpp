@@ -0,0 +1,102 @@
+#include "bench_runner.h"
+#include "json.h"
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	/*Json::Number before std::to_chars: the whole part and 19 digits of the fractional one,
+	both written with std::to_string (the fractional one padded with zeros)*/
+	struct SplitNumber {
+		uint64_t whole{ 0 };
+		uint64_t fractional{ 0 };
+		static constexpr uint64_t precision{ numeric_limits<uint64_t>::digits10 };
+
+		explicit SplitNumber(double number) noexcept
+			: whole{ static_cast<uint64_t>(number) },
+			fractional{ static_cast<uint64_t>((number - whole) * pow(static_cast<uint64_t>(10), precision)) } {
+		}
+	};
+
+	string number_to_string(uint64_t number, optional<size_t> required_length = nullopt) {
+		string result{ to_string(number) };
+		if (required_length) {
+			if (*required_length <= result.length()) {
+				result.resize(*required_length);
+			}
+			else {
+				result.insert(0, *required_length - result.length(), '0');
+			}
+		}
+		return result;
+	}
+
+	string serialize(const vector<SplitNumber>& numbers) {
+		string output{ "[" };
+		for (const auto& number : numbers) {
+			string result;
+			result.reserve(2 * SplitNumber::precision + 2);
+			result += number_to_string(number.whole);
+			result.push_back('.');
+			result += number_to_string(number.fractional, SplitNumber::precision);
+			output += result;
+			output.push_back(',');
+		}
+		output.back() = ']';
+		return output;
+	}
+
+	string serialize(const Json::array_t& numbers, optional<int> precision) {
+		string output;
+		Json::Writer(output, Json::Format::COMPACT, precision).Write(numbers);
+		return output;
+	}
+}
+
+/*Serialization of the numbers like total_time and route_length:
+JsonNumberBench [number count] [runs]*/
+int main(int argc, char* argv[]) {
+	const size_t count{ bench::GetArgument(argc, argv, 1, 1000000) };
+	const size_t runs{ bench::GetArgument(argc, argv, 2, 5) };
+	mt19937 random(6);
+	uniform_real_distribution<double> times(0, 1000);
+	vector<double> values(count);
+	for (auto& value : values) {
+		value = times(random);
+	}
+
+	/*The numbers are made once, when the answers are built, and written once*/
+	vector<SplitNumber> split_numbers;
+	split_numbers.reserve(count);
+	const auto split_making{ bench::Measure(runs, [&]() {
+		split_numbers.clear();
+		for (const double value : values) {
+			split_numbers.emplace_back(value);
+		}
+		}) };
+	bench::Report("split with pow: make", split_making);
+	vector<Json::Number> native_numbers;
+	native_numbers.reserve(count);
+	const auto making{ bench::Measure(runs, [&]() {
+		native_numbers.clear();
+		for (const double value : values) {
+			native_numbers.emplace_back(value);
+		}
+		}) };
+	bench::Report("native double: make", making, bench::Speedup(split_making, making));
+	const Json::array_t numbers(native_numbers.begin(), native_numbers.end());
+
+	size_t size{ 0 };
+	const auto split{ bench::Measure(runs, [&]() { size = serialize(split_numbers).size(); }) };
+	bench::Report("to_string, 19 digits: write", split, to_string(size) + " bytes");
+	const auto shortest{ bench::Measure(runs, [&]() { size = serialize(numbers, nullopt).size(); }) };
+	bench::Report("to_chars, shortest: write", shortest, to_string(size) + " bytes, " + bench::Speedup(split, shortest));
+	const auto fixed{ bench::Measure(runs, [&]() { size = serialize(numbers, 6).size(); }) };
+	bench::Report("to_chars, 6 digits: write", fixed, to_string(size) + " bytes, " + bench::Speedup(split, fixed));
+	return 0;
+}
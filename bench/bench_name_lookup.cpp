@@ -0,0 +1,115 @@
+#include "bench_runner.h"
+#include "network_generator.h"
+#include "transport_catalog.h"
+#include "perfect_hash.h"
+
+#include <deque>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	/*Known names in random order, every tenth one is unknown*/
+	vector<string_view> make_queries(const vector<string_view>& names, const deque<string>& unknown_names, size_t count, uint32_t seed) {
+		mt19937 random(seed);
+		vector<string_view> queries;
+		queries.reserve(count);
+		for (size_t query = 0; query < count; ++query) {
+			queries.push_back(query % 10 == 9 ?
+				string_view(unknown_names[random() % unknown_names.size()]) :
+				names[random() % names.size()]
+			);
+		}
+		return queries;
+	}
+
+	template <typename Find>
+	bench::Duration measure_lookups(size_t runs, const vector<string_view>& queries, Find find) {
+		return bench::Measure(runs, [&]() {
+			uint64_t found{ 0 };
+			for (const auto query : queries) {
+				found += find(query);
+			}
+			bench::KeepAlive(found);
+			});
+	}
+
+	string per_lookup(bench::Duration duration, size_t count) {
+		return to_string(static_cast<size_t>(duration.count() * 1e6 / count)) + " ns per lookup";
+	}
+
+	/*The name to id maps the catalog used before the perfect hash, and the perfect hash itself*/
+	void run_indexes(const vector<string_view>& names, const vector<string_view>& queries, size_t runs) {
+		map<string_view, uint32_t> ordered;
+		unordered_map<string_view, uint32_t> hashed;
+		for (uint32_t id = 0; id < names.size(); ++id) {
+			ordered.emplace(names[id], id);
+			hashed.emplace(names[id], id);
+		}
+		const algo::hash::PerfectHashIndex<uint32_t> perfect(names);
+
+		const auto ordered_time{ measure_lookups(runs, queries, [&ordered](string_view name) {
+			const auto it{ ordered.find(name) };
+			return it == ordered.end() ? 0 : it->second + 1;
+			}) };
+		bench::Report("std::map", ordered_time, per_lookup(ordered_time, queries.size()));
+		const auto hashed_time{ measure_lookups(runs, queries, [&hashed](string_view name) {
+			const auto it{ hashed.find(name) };
+			return it == hashed.end() ? 0 : it->second + 1;
+			}) };
+		bench::Report("std::unordered_map", hashed_time,
+			per_lookup(hashed_time, queries.size()) + ", " + bench::Speedup(ordered_time, hashed_time));
+		const auto perfect_time{ measure_lookups(runs, queries, [&perfect](string_view name) {
+			const auto id{ perfect.Find(name) };
+			return id ? *id + 1 : 0;
+			}) };
+		bench::Report("PerfectHashIndex", perfect_time,
+			per_lookup(perfect_time, queries.size()) + ", " + bench::Speedup(ordered_time, perfect_time)
+			+ ", " + bench::Speedup(hashed_time, perfect_time) + " vs unordered_map");
+	}
+}
+
+/*Read-path name lookups: the indexes alone, then Bus and Stop requests to a synchronized catalog:
+NameLookupBench [stop count] [query count] [runs]*/
+int main(int argc, char* argv[]) {
+	const generator::Parameters parameters{
+		.stop_count = bench::GetArgument(argc, argv, 1, 20000),
+		.bus_count = bench::GetArgument(argc, argv, 1, 20000) / 10,
+		.max_route_stops = 20
+	};
+	const size_t query_count{ bench::GetArgument(argc, argv, 2, 1000000) };
+	const size_t runs{ bench::GetArgument(argc, argv, 3, 5) };
+	auto network{ generator::MakeNetwork(parameters) };
+	deque<string> unknown_names;
+	for (size_t i = 0; i < 100; ++i) {
+		unknown_names.push_back("Unknown " + to_string(i));
+	}
+
+	TransportCatalog tr_catalog;
+	tr_catalog.SetRoutingSettings(generator::MakeRoutingSettings());
+#ifdef RENDER
+	tr_catalog.SetRenderSettings(generator::MakeRenderSettings());
+#endif
+	for (const auto& stop : network.stops) {
+		tr_catalog.AddStop(stop);
+	}
+	for (const auto& bus : network.buses) {
+		tr_catalog.AddBus(bus);
+	}
+	tr_catalog.Synchronize();
+
+	for (const auto& [kind, names] : { pair{ "Stop", tr_catalog.GetStopNames() }, pair{ "Bus", tr_catalog.GetBusNames() } }) {
+		const auto queries{ make_queries(names, unknown_names, query_count, parameters.seed) };
+		cout << "--- " << kind << ": " << names.size() << " names, " << queries.size() << " queries" << endl;
+		run_indexes(names, queries, runs);
+		const auto requests{ kind == string_view("Stop") ?
+			measure_lookups(runs, queries, [&tr_catalog](string_view name) { return tr_catalog.GetStopInfo(name) ? 1 : 0; }) :
+			measure_lookups(runs, queries, [&tr_catalog](string_view name) { return tr_catalog.GetBusInfo(name) ? 1 : 0; })
+		};
+		bench::Report(string("Get") + kind + "Info", requests, per_lookup(requests, queries.size()));
+	}
+	return 0;
+}
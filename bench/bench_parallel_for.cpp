@@ -0,0 +1,67 @@
+#include "bench_runner.h"
+#include "execution.h"
+
+#include <future>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	/*parallel_for before the thread pool: a std::async task per page on every call,
+	waited for by the destructors of the futures*/
+	template<class ForwardIt, class Function>
+	void async_for(size_t thread_count, ForwardIt first, ForwardIt last, Function func) {
+		vector<future<void>> futures;
+		size_t residual_size{ static_cast<size_t>(distance(first, last)) };
+		auto [page_size, page_count] { algo::execution::calculate_page_size(residual_size, thread_count) };
+		futures.reserve(page_count);
+		while (page_count--) {
+			auto bound{ first };
+			advance(bound, min(page_size, residual_size));
+			futures.push_back(async(algo::execution::sequential_for<ForwardIt, Function>, first, bound, func));
+			first = bound;
+			residual_size -= min(page_size, residual_size);
+		}
+	}
+
+	/*Time of all the calls of the loop over the items (each item is incremented)*/
+	template <typename Loop>
+	bench::Duration measure(size_t calls, size_t item_count, Loop loop) {
+		vector<uint64_t> items(item_count);
+		const auto duration{ bench::Measure(1, [&]() {
+			for (size_t call = 0; call < calls; ++call) {
+				loop(items.begin(), items.end(), [](uint64_t& item) { ++item; });
+			}
+			}) };
+		bench::KeepAlive(items);
+		return duration;
+	}
+
+	string per_call(bench::Duration duration, size_t calls) {
+		return to_string(static_cast<size_t>(duration.count() * 1000 / calls)) + " us per call";
+	}
+}
+
+/*Scheduling overhead of parallel_for with std::async and with a persistent pool:
+ParallelForBench [calls] [items per call]*/
+int main(int argc, char* argv[]) {
+	const size_t calls{ bench::GetArgument(argc, argv, 1, 2000) };
+	const size_t item_count{ bench::GetArgument(argc, argv, 2, 16) };
+	cout << "Hardware threads: " << algo::execution::hardware_thread_count()
+		<< ", " << calls << " calls over " << item_count << " items" << endl;
+
+	for (const size_t thread_count : { 2, 4, 8 }) {
+		const string threads{ to_string(thread_count) + " threads" };
+		const auto with_async{ measure(calls, item_count, [thread_count](auto first, auto last, auto func) {
+			async_for(thread_count, first, last, func);
+			}) };
+		bench::Report("std::async per page, " + threads, with_async, per_call(with_async, calls));
+
+		algo::execution::ThreadPool pool({ .thread_count = thread_count });
+		const auto pooled{ measure(calls, item_count, [&pool](auto first, auto last, auto func) {
+			algo::execution::parallel_for(pool, first, last, func);
+			}) };
+		bench::Report("thread pool, " + threads, pooled, per_call(pooled, calls) + ", " + bench::Speedup(with_async, pooled));
+	}
+	return 0;
+}
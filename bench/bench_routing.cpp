@@ -0,0 +1,143 @@
+#include "bench_runner.h"
+#include "navigator.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	using Weight = double;
+	using Frozen = Graph::FrozenGraph<Weight, uint8_t>;
+	using Distances = vector<optional<Weight>>;
+
+	/*Square grid with two-way streets of random length*/
+	Frozen make_grid(size_t side, uint32_t seed) {
+		mt19937 random(seed);
+		uniform_real_distribution<Weight> weight(1, 10);
+		Frozen::Builder builder(side * side);
+		auto connect{ [&](Graph::VertexId from, Graph::VertexId to) {
+			builder.AddEdge({ from, to, weight(random), 0 });
+			builder.AddEdge({ to, from, weight(random), 0 });
+		} };
+		for (size_t row = 0; row < side; ++row) {
+			for (size_t column = 0; column < side; ++column) {
+				const size_t vertex{ row * side + column };
+				if (column + 1 < side) {
+					connect(vertex, vertex + 1);
+				}
+				if (row + 1 < side) {
+					connect(vertex, vertex + side);
+				}
+			}
+		}
+		return Frozen(builder);
+	}
+
+	/*relax_routes before the indexed heap: std::set keyed by the edge weight instead of the tentative distance,
+	so a vertex may leave the heap many times (a label-correcting search)*/
+	Distances search_with_set(const Frozen& graph, Graph::VertexId from, size_t* pops) {
+		Distances distances(graph.GetVertexCount());
+		set<pair<Weight, Graph::VertexId>> search_heap;
+		search_heap.insert({ 0, from });
+		distances[from] = 0;
+		while (!search_heap.empty()) {
+			const Graph::VertexId from_id{ search_heap.begin()->second };
+			search_heap.erase(search_heap.begin());
+			++*pops;
+			for (const auto edge_id : graph.GetOutgoingEdges(from_id)) {
+				const auto to_id{ graph.GetTarget(edge_id) };
+				const Weight next_weight{ graph.GetWeight(edge_id) };
+				if (!distances[to_id] || *distances[from_id] + next_weight < *distances[to_id]) {
+					distances[to_id] = *distances[from_id] + next_weight;
+					search_heap.insert({ next_weight, to_id });
+				}
+			}
+		}
+		return distances;
+	}
+
+	/*relax_routes now: Graph::IndexedHeap keyed by the tentative distance, each vertex is settled once*/
+	Distances search_with_heap(const Frozen& graph, Graph::VertexId from, size_t* pops) {
+		Distances distances(graph.GetVertexCount());
+		Graph::IndexedHeap<Weight> search_heap(graph.GetVertexCount());
+		search_heap.Push(from, 0);
+		distances[from] = 0;
+		while (!search_heap.Empty()) {
+			const auto [from_distance, from_id] { search_heap.Pop() };
+			++*pops;
+			for (const auto edge_id : graph.GetOutgoingEdges(from_id)) {
+				const auto to_id{ graph.GetTarget(edge_id) };
+				const Weight distance{ from_distance + graph.GetWeight(edge_id) };
+				if (!distances[to_id] || distance < *distances[to_id]) {
+					distances[to_id] = distance;
+					search_heap.Push(to_id, distance);
+				}
+			}
+		}
+		return distances;
+	}
+
+	bool same_distances(const Distances& lhs, const Distances& rhs) {
+		for (size_t vertex = 0; vertex < lhs.size(); ++vertex) {
+			if (lhs[vertex].has_value() != rhs[vertex].has_value() ||
+				(lhs[vertex] && abs(*lhs[vertex] - *rhs[vertex]) > 1e-9 * *rhs[vertex])) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+/*Single-source searches on a synthetic grid: heap pops (settled vertices) and wall time of both heaps,
+then Navigator::BuildRoute from the same sources:
+RoutingBench [grid side] [searches]*/
+int main(int argc, char* argv[]) {
+	const size_t side{ bench::GetArgument(argc, argv, 1, 200) };
+	const size_t search_count{ bench::GetArgument(argc, argv, 2, 10) };
+	const auto graph{ make_grid(side, 24) };
+	cout << "Grid " << side << "x" << side << ": " << graph.GetVertexCount() << " vertices, "
+		<< graph.GetEdgeCount() << " edges, " << search_count << " searches" << endl;
+
+	mt19937 random(24);
+	vector<Graph::VertexId> sources(search_count);
+	for (auto& source : sources) {
+		source = random() % graph.GetVertexCount();
+	}
+
+	size_t set_pops{ 0 }, heap_pops{ 0 };
+	vector<Distances> set_distances, heap_distances;
+	const auto set_time{ bench::Measure(1, [&]() {
+		for (const auto source : sources) {
+			set_distances.push_back(search_with_set(graph, source, &set_pops));
+		}
+		}) };
+	bench::Report("std::set by edge weight", set_time, to_string(set_pops) + " pops");
+	const auto heap_time{ bench::Measure(1, [&]() {
+		for (const auto source : sources) {
+			heap_distances.push_back(search_with_heap(graph, source, &heap_pops));
+		}
+		}) };
+	bench::Report("IndexedHeap by distance", heap_time,
+		to_string(heap_pops) + " pops, " + bench::Speedup(set_time, heap_time));
+	for (size_t search = 0; search < search_count; ++search) {
+		if (!same_distances(set_distances[search], heap_distances[search])) {
+			cerr << "The distances differ from the source " << sources[search] << endl;
+			return 1;
+		}
+	}
+	cout << "The distances are the same" << endl;
+
+	/*Each source is a new search tree of the navigator (the trees are cached)*/
+	const Graph::Navigator<Frozen> navigator(graph);
+	const auto navigator_time{ bench::Measure(1, [&]() {
+		for (const auto source : sources) {
+			bench::KeepAlive(navigator.BuildRoute(source, graph.GetVertexCount() - 1 - source));
+		}
+		}) };
+	bench::Report("Navigator::BuildRoute", navigator_time, "tree and route");
+	return 0;
+}
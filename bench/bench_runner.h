@@ -0,0 +1,65 @@
+#pragma once
+
+/*Standart headers*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/*Timed drivers for the benchmarks: each case is run several times and the best time is reported
+(the numbers are only meaningful in an optimized build, see bench/README.md)*/
+namespace bench {
+	using Duration = std::chrono::duration<double, std::milli>;
+
+	/*Keeps the computed value alive, so the optimizer can't drop the measured code*/
+	template <typename T>
+	inline void KeepAlive(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	/*Best of the runs: a run is a call of func()*/
+	template <typename Func>
+	Duration Measure(size_t runs, Func func) {
+		Duration best{ Duration::max() };
+		for (size_t run = 0; run < runs; ++run) {
+			const auto start{ std::chrono::steady_clock::now() };
+			func();
+			best = std::min<Duration>(best, std::chrono::steady_clock::now() - start);
+		}
+		return best;
+	}
+
+	/*One line of the report: the case name, the time and a free-form note (e.g. throughput)*/
+	inline void Report(std::string_view name, Duration duration, std::string_view note = {}) {
+		std::cout << std::left << std::setw(40) << name
+			<< std::right << std::setw(12) << std::fixed << std::setprecision(3) << duration.count() << " ms";
+		if (!note.empty()) {
+			std::cout << "  " << note;
+		}
+		std::cout << std::endl;
+	}
+
+	/*Throughput note in MB/s*/
+	inline std::string Throughput(size_t bytes, Duration duration) {
+		return std::to_string(static_cast<size_t>(bytes / 1e6 / (duration.count() / 1e3))) + " MB/s";
+	}
+
+	/*Ratio note of the reference time to the measured one*/
+	inline std::string Speedup(Duration reference, Duration duration) {
+		const auto tenths{ static_cast<long long>(reference / duration * 10 + 0.5) };
+		return "x" + std::to_string(tenths / 10) + "." + std::to_string(tenths % 10);
+	}
+
+	/*Positional argument of the driver (or the default)*/
+	inline size_t GetArgument(int argc, char* argv[], int index, size_t default_value) {
+		return index < argc ? std::strtoull(argv[index], nullptr, 10) : default_value;
+	}
+}
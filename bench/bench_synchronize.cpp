@@ -0,0 +1,60 @@
+#include "bench_runner.h"
+#include "network_generator.h"
+#include "transport_catalog.h"
+
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	unique_ptr<TransportCatalog> stage_catalog(const generator::Network& network) {
+		auto tr_catalog{ make_unique<TransportCatalog>() };
+		tr_catalog->SetRoutingSettings(generator::MakeRoutingSettings());
+#ifdef RENDER
+		tr_catalog->SetRenderSettings(generator::MakeRenderSettings());
+#endif
+		for (const auto& stop : network.stops) {
+			tr_catalog->AddStop(stop);
+		}
+		for (const auto& bus : network.buses) {
+			tr_catalog->AddBus(bus);
+		}
+		return tr_catalog;
+	}
+}
+
+/*Synchronize of the catalog with dense ids and struct-of-arrays storage, stage by stage (the stages of the best run):
+SynchronizeBench [stop count] [runs]*/
+int main(int argc, char* argv[]) {
+	const generator::Parameters parameters{
+		.stop_count = bench::GetArgument(argc, argv, 1, 20000),
+		.bus_count = bench::GetArgument(argc, argv, 1, 20000) / 10,
+		.max_route_stops = 30
+	};
+	const size_t runs{ bench::GetArgument(argc, argv, 2, 5) };
+	const auto network{ generator::MakeNetwork(parameters) };
+	cout << network.stops.size() << " stops, " << network.buses.size() << " buses" << endl;
+
+	bench::Duration best{ bench::Duration::max() };
+	vector<TransportCatalog::SyncStageTiming> stages;
+	for (size_t run = 0; run < runs; ++run) {
+		auto tr_catalog{ stage_catalog(network) };
+		const auto duration{ bench::Measure(1, [&tr_catalog]() { tr_catalog->Synchronize(); }) };
+		if (duration < best) {
+			best = duration;
+			stages = tr_catalog->GetSyncStats();
+		}
+#ifdef RENDER
+		if (run + 1 == runs) {
+			const auto map{ bench::Measure(1, [&tr_catalog]() { bench::KeepAlive(tr_catalog->GetMap()); }) };
+			bench::Report("GetMap (first call)", map);
+		}
+#endif
+	}
+	bench::Report("Synchronize", best);
+	for (const auto& [stage, duration] : stages) {
+		bench::Report("  " + string(stage), duration);
+	}
+	return 0;
+}
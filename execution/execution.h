@@ -1,17 +1,18 @@
 #pragma once
 
 /*Standart headers*/
-#include <thread>
-#include <future>
-#include <mutex>
-#include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <type_traits>
 
+#include "thread_pool.h"
+#include "work_stealing.h"
+#include "task.h"
+
 /*C++17 or newer required*/
 namespace algo::execution {
-	size_t hardware_thread_count();
-
 	struct Pages {
 		size_t size,
 			count;
@@ -25,35 +26,103 @@ namespace algo::execution {
 		}
 	}
 
+	/*Pages run on the pool and on the calling thread, which waits for all of them.
+	Nested calls from the pool workers run sequentially (a worker must not wait for its own pool)*/
+	template<class ForwardIt, class Function>
+	void parallel_for(ThreadPool& pool, ForwardIt first, ForwardIt last, Function func) {
+		if (pool.Size() < 2 || pool.IsWorkerThread()) {
+			sequential_for(first, last, func);
+			return;
+		}
+
+		size_t residual_size{ static_cast<size_t>(std::distance(first, last)) };
+		auto [page_size, page_count] { calculate_page_size(residual_size, pool.Size()) };
+		detail::PageLatch latch(page_count);
+
+		auto own_bound{ first };
+		std::advance(own_bound, std::min(page_size, residual_size));		//The first page is processed by the caller
+		residual_size -= std::min(page_size, residual_size);
+
+		for (auto page_first{ own_bound }; --page_count; ) {
+			auto bound{ page_first };
+			std::advance(
+				bound,
+				std::min(page_size, residual_size)
+			);
+			pool.Post([page_first, bound, func, &latch]() {
+				auto page{ [&]() {
+					sequential_for(page_first, bound, func);
+				} };
+				latch.Run(page);
+				});
+			page_first = bound;
+			residual_size -= std::min(page_size, residual_size);
+		}
+
+		auto own_page{ [&]() {
+			sequential_for(first, own_bound, func);
+		} };
+		latch.Run(own_page);
+		latch.Wait();
+	}
+
+	/*Same on the shared pool (sequential on a single-core machine)*/
 	template<class ForwardIt, class Function>
 	void parallel_for(ForwardIt first, ForwardIt last, Function func) {
-		const size_t thread_count{ hardware_thread_count() };
-		if (thread_count < 2) {
+		if (hardware_thread_count() < 2) {
 			sequential_for(first, last, func);
+			return;
 		}
-		else {
-			std::vector<std::future<void>> futures;
-			size_t residual_size{ static_cast<size_t>(std::distance(first,last)) };
-			auto [page_size, page_count] { calculate_page_size(residual_size, thread_count) };
-			futures.reserve(page_count);
-
-			while (page_count--) {
-				auto bound{ first };
-				std::advance(
-					bound,
-					std::min(page_size, residual_size)
-				);
-				futures.push_back(
-					std::async(
-						sequential_for<ForwardIt, Function>,
-						first,
-						bound,
-						func
-					)
-				);
-				first = bound;
-				residual_size -= page_size;		//There may be overflow
+		parallel_for(default_pool(), first, last, func);
+	}
+
+	/*Work-stealing loop for items of very different cost (e.g. requests): the pool workers and the caller
+	take chunks of their own ranges, then steal from the others. A slow item delays only its own chunk,
+	and the chunks shrink to single items when the work is almost done*/
+	template<class RandomIt, class Function>
+	void dynamic_for(RandomIt first, RandomIt last, Function func) {
+		const size_t item_count{ static_cast<size_t>(std::distance(first, last)) };
+		if (hardware_thread_count() < 2 || item_count < 2) {
+			sequential_for(first, last, func);
+			return;
+		}
+		ThreadPool& pool{ default_pool() };
+		if (pool.Size() < 2 || pool.IsWorkerThread()) {
+			sequential_for(first, last, func);
+			return;
+		}
+		if (item_count > UINT32_MAX) {		//Ranges are packed into 32-bit halves
+			parallel_for(first, last, func);
+			return;
+		}
+
+		const size_t participant_count{ std::min(pool.Size(), item_count) };
+		detail::StealingRanges ranges(item_count, participant_count);
+		detail::PageLatch latch(participant_count);
+
+		auto participate{ [first, &ranges](size_t participant, Function& func) {
+			while (true) {
+				const auto [chunk_first, chunk_last] { ranges.Next(participant) };
+				if (chunk_first == chunk_last) {
+					return;
+				}
+				sequential_for(first + chunk_first, first + chunk_last, std::ref(func));
 			}
+		} };
+
+		for (size_t participant = 1; participant < participant_count; ++participant) {
+			pool.Post([participant, func, &participate, &latch]() mutable {
+				auto work{ [&]() {
+					participate(participant, func);
+				} };
+				latch.Run(work);
+				});
 		}
+
+		auto own_work{ [&]() {
+			participate(0, func);
+		} };
+		latch.Run(own_work);
+		latch.Wait();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+/*Standart headers*/
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace algo::execution {
+	/*One instance of Ty for each thread that accessed it: Local() takes a lock only on the first access
+	of a thread, after that the instance is found in a thread_local cache. The cache is shared by all the
+	PerThread<Ty> and indexed by the instance key, so up to cache_ways live instances don't evict each other.
+	ForEach() and Clear() must not run concurrently with Local()*/
+	template <class Ty>
+	class PerThread {
+	public:
+		PerThread() = default;
+		PerThread(const PerThread&) = delete;
+		PerThread& operator=(const PerThread&) = delete;
+
+		Ty& Local() {
+			thread_local std::array<Cache, cache_ways> caches;
+			Cache& cache{ caches[key % cache_ways] };
+			if (cache.key != key) {
+				cache.key = key;
+				cache.value = std::addressof(register_thread());
+			}
+			return *cache.value;
+		}
+
+		template <class Function>
+		void ForEach(Function func) {
+			for (auto& slot : slots) {
+				func(slot->value);
+			}
+		}
+
+		/*Drops all the instances (the cached pointers become stale, so a new key is taken)*/
+		void Clear() {
+			slots.clear();
+			key = next_key();
+		}
+	private:
+		static constexpr uint64_t cache_ways{ 8 };
+
+		struct Slot {
+			std::thread::id owner;
+			Ty value;
+		};
+		struct Cache {
+			uint64_t key{ 0 };
+			Ty* value{ nullptr };
+		};
+
+		/*Keys are never reused, so a cache entry can't point to another PerThread*/
+		static uint64_t next_key() noexcept {
+			static std::atomic<uint64_t> last_key{ 0 };
+			return last_key.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+
+		Ty& register_thread() {
+			const auto owner{ std::this_thread::get_id() };
+			std::lock_guard lock(mutex);
+			for (auto& slot : slots) {
+				if (slot->owner == owner) {
+					return slot->value;
+				}
+			}
+			slots.push_back(std::make_unique<Slot>(Slot{ owner, Ty{} }));
+			return slots.back()->value;
+		}
+	private:
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Slot>> slots;
+		uint64_t key{ next_key() };
+	};
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+/*Standart headers*/
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+#include "work_stealing.h"
+
+/*C++20 coroutines: lazily started tasks, a pool scheduler and the joins (when_all, sync_wait)*/
+namespace algo::execution {
+	template <class Ty = void>
+	class Task;
+
+	namespace detail {
+		/*The awaiting coroutine is resumed by symmetric transfer when the task ends*/
+		class PromiseBase {
+		private:
+			struct FinalAwaiter {
+				bool await_ready() const noexcept {
+					return false;
+				}
+				template <class Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+					const auto continuation{ handle.promise().continuation };
+					return continuation ? continuation : std::noop_coroutine();
+				}
+				void await_resume() const noexcept {
+				}
+			};
+		public:
+			std::suspend_always initial_suspend() const noexcept {
+				return {};
+			}
+			FinalAwaiter final_suspend() const noexcept {
+				return {};
+			}
+			void unhandled_exception() noexcept {
+				exception = std::current_exception();
+			}
+			void set_continuation(std::coroutine_handle<> continuation_) noexcept {
+				continuation = continuation_;
+			}
+		protected:
+			void rethrow_if_failed() const {
+				if (exception) {
+					std::rethrow_exception(exception);
+				}
+			}
+		private:
+			std::coroutine_handle<> continuation;
+			std::exception_ptr exception;
+		};
+
+		template <class Ty>
+		class Promise : public PromiseBase {
+		public:
+			Task<Ty> get_return_object() noexcept;
+
+			template <class Value>
+			void return_value(Value&& value_) {
+				value.emplace(std::forward<Value>(value_));
+			}
+			Ty take_result() {
+				rethrow_if_failed();
+				return std::move(*value);
+			}
+		private:
+			std::optional<Ty> value;
+		};
+
+		template <>
+		class Promise<void> : public PromiseBase {
+		public:
+			Task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {
+			}
+			void take_result() const {
+				rethrow_if_failed();
+			}
+		};
+	}
+
+	/*Lazily started coroutine: it runs when awaited and resumes the awaiting coroutine when finished.
+	A task is awaited once*/
+	template <class Ty>
+	class [[nodiscard]] Task {
+	public:
+		using promise_type = detail::Promise<Ty>;
+	private:
+		struct Awaiter {
+			std::coroutine_handle<promise_type> handle;
+
+			bool await_ready() const noexcept {
+				return !handle || handle.done();
+			}
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+				handle.promise().set_continuation(awaiting);
+				return handle;
+			}
+			Ty await_resume() const {
+				return handle.promise().take_result();
+			}
+		};
+	public:
+		Task(Task&& other) noexcept
+			: handle{ std::exchange(other.handle, nullptr) } {
+		}
+		Task& operator=(Task&& other) noexcept {
+			if (this != &other) {
+				destroy();
+				handle = std::exchange(other.handle, nullptr);
+			}
+			return *this;
+		}
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+		~Task() {
+			destroy();
+		}
+
+		Awaiter operator co_await() && noexcept {
+			return Awaiter{ handle };
+		}
+	private:
+		friend promise_type;
+
+		explicit Task(std::coroutine_handle<promise_type> handle_) noexcept
+			: handle{ handle_ } {
+		}
+		void destroy() noexcept {
+			if (handle) {
+				handle.destroy();
+			}
+		}
+	private:
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	namespace detail {
+		template <class Ty>
+		Task<Ty> Promise<Ty>::get_return_object() noexcept {
+			return Task<Ty>(std::coroutine_handle<Promise>::from_promise(*this));
+		}
+
+		inline Task<void> Promise<void>::get_return_object() noexcept {
+			return Task<void>(std::coroutine_handle<Promise>::from_promise(*this));
+		}
+
+		/*Coroutine that starts at once and frees itself at the end (it is the bridge to the joins)*/
+		struct Detached {
+			struct promise_type {
+				Detached get_return_object() const noexcept {
+					return {};
+				}
+				std::suspend_never initial_suspend() const noexcept {
+					return {};
+				}
+				std::suspend_never final_suspend() const noexcept {
+					return {};
+				}
+				void return_void() const noexcept {
+				}
+				void unhandled_exception() const noexcept {
+					std::terminate();		//Exceptions are caught by the runners
+				}
+			};
+		};
+
+		/*Result (or exception) of a task started by a join*/
+		template <class Ty>
+		struct ResultSlot {
+			std::optional<Ty> value;
+			std::exception_ptr exception;
+
+			template <class Awaitable>
+			Task<void> fill(Awaitable awaitable) {
+				value.emplace(co_await std::move(awaitable));
+			}
+			Ty take() {
+				if (exception) {
+					std::rethrow_exception(exception);
+				}
+				return std::move(*value);
+			}
+		};
+
+		template <>
+		struct ResultSlot<void> {
+			std::exception_ptr exception;
+
+			template <class Awaitable>
+			Task<void> fill(Awaitable awaitable) {
+				co_await std::move(awaitable);
+			}
+			void take() const {
+				if (exception) {
+					std::rethrow_exception(exception);
+				}
+			}
+		};
+
+		/*Runs the task and reports its completion (Completion::Arrive())*/
+		template <class Ty, class Completion>
+		Detached run_detached(Task<Ty> task, ResultSlot<Ty>& slot, Completion& completion) {
+			try {
+				co_await slot.fill(std::move(task));
+			}
+			catch (...) {
+				slot.exception = std::current_exception();
+			}
+			completion.Arrive();
+		}
+
+		/*The last finished task resumes the coroutine awaiting when_all (the counter starts from count + 1,
+		so the one that arrives after the awaiting coroutine has suspended resumes it)*/
+		class WhenAllCounter {
+		public:
+			explicit WhenAllCounter(size_t count) noexcept
+				: pending{ count + 1 } {
+			}
+			bool await_ready() const noexcept {
+				return false;
+			}
+			bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+				continuation = awaiting;
+				return pending.fetch_sub(1, std::memory_order_acq_rel) > 1;
+			}
+			void await_resume() const noexcept {
+			}
+			void Arrive() noexcept {
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					continuation.resume();
+				}
+			}
+		private:
+			std::atomic<size_t> pending;
+			std::coroutine_handle<> continuation;
+		};
+
+		/*sync_wait completion (notified under the lock: the waiter may destroy it right after waking up)*/
+		class BlockingCompletion {
+		public:
+			void Arrive() noexcept {
+				std::lock_guard lock(mutex);
+				done = true;
+				finished.notify_one();
+			}
+			void Wait() {
+				std::unique_lock lock(mutex);
+				finished.wait(lock, [this]() {
+					return done;
+					});
+			}
+		private:
+			std::mutex mutex;
+			std::condition_variable finished;
+			bool done{ false };
+		};
+	}
+
+	/*co_await schedule_on(pool) continues the coroutine on a pool worker*/
+	inline auto schedule_on(ThreadPool& pool) noexcept {
+		struct Awaiter {
+			ThreadPool& pool;
+
+			bool await_ready() const noexcept {
+				return false;
+			}
+			void await_suspend(std::coroutine_handle<> handle) const {
+				pool.Post([handle]() {
+					handle.resume();
+					});
+			}
+			void await_resume() const noexcept {
+			}
+		};
+		return Awaiter{ pool };
+	}
+
+	/*Starts all the tasks and resumes when the last one finishes. The tasks run concurrently if they
+	begin with schedule_on. Results keep the order of the tasks; the first exception is rethrown*/
+	template <class Ty>
+	Task<std::vector<Ty>> when_all(std::vector<Task<Ty>> tasks) {
+		std::vector<detail::ResultSlot<Ty>> slots(tasks.size());
+		detail::WhenAllCounter counter(tasks.size());
+		for (size_t idx = 0; idx < tasks.size(); ++idx) {
+			detail::run_detached(std::move(tasks[idx]), slots[idx], counter);
+		}
+		co_await counter;
+
+		std::vector<Ty> results;
+		results.reserve(slots.size());
+		for (auto& slot : slots) {
+			results.push_back(slot.take());
+		}
+		co_return results;
+	}
+
+	inline Task<void> when_all(std::vector<Task<void>> tasks) {
+		std::vector<detail::ResultSlot<void>> slots(tasks.size());
+		detail::WhenAllCounter counter(tasks.size());
+		for (size_t idx = 0; idx < tasks.size(); ++idx) {
+			detail::run_detached(std::move(tasks[idx]), slots[idx], counter);
+		}
+		co_await counter;
+
+		for (auto& slot : slots) {
+			slot.take();
+		}
+	}
+
+	/*Blocks the calling thread (not a pool worker) until the task is finished*/
+	template <class Ty>
+	Ty sync_wait(Task<Ty> task) {
+		detail::ResultSlot<Ty> slot;
+		detail::BlockingCompletion completion;
+		detail::run_detached(std::move(task), slot, completion);
+		completion.Wait();
+		return slot.take();
+	}
+
+	namespace detail {
+		template <class RandomIt, class Function>
+		Task<void> steal_and_run(ThreadPool& pool, StealingRanges& ranges, size_t participant, RandomIt first, Function& func) {
+			co_await schedule_on(pool);
+			while (true) {
+				const auto [chunk_first, chunk_last] { ranges.Next(participant) };
+				if (chunk_first == chunk_last) {
+					co_return;
+				}
+				for (auto it = first + chunk_first; it != first + chunk_last; ++it) {
+					func(*it);
+				}
+			}
+		}
+	}
+
+	/*Awaitable version of dynamic_for: the work-stealing loop runs on the pool workers,
+	the awaiting coroutine is suspended (no thread is blocked) and resumed by the last participant*/
+	template <class RandomIt, class Function>
+	Task<void> async_for(RandomIt first, RandomIt last, Function func) {
+		const size_t item_count{ static_cast<size_t>(std::distance(first, last)) };
+		ThreadPool& pool{ default_pool() };
+		if (item_count == 0) {
+			co_return;
+		}
+
+		const size_t participant_count{ std::min(pool.Size(), item_count) };
+		detail::StealingRanges ranges(item_count, participant_count);
+		std::vector<Task<void>> participants;
+		participants.reserve(participant_count);
+		for (size_t participant = 0; participant < participant_count; ++participant) {
+			participants.push_back(detail::steal_and_run(pool, ranges, participant, first, func));
+		}
+		co_await when_all(std::move(participants));
+	}
+}
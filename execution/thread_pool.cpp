@@ -0,0 +1,126 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace algo::execution {
+	namespace {
+		thread_local const ThreadPool* current_pool{ nullptr };
+
+		void pin_to_cpu([[maybe_unused]] std::thread& thread, [[maybe_unused]] size_t cpu) {
+#ifdef __linux__
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+			CPU_SET(cpu % CPU_SETSIZE, &cpu_set);
+			pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);		//Pinning is a hint: errors are ignored
+#endif
+		}
+
+		PoolSettings& default_settings() {
+			static PoolSettings settings;
+			return settings;
+		}
+	}
+
+	ThreadPool::ThreadPool(PoolSettings settings) {
+		const size_t thread_count{ std::max<size_t>(settings.thread_count, 1) };
+		workers.reserve(thread_count);
+		for (size_t idx = 0; idx < thread_count; ++idx) {
+			workers.emplace_back([this]() {
+				work();
+				});
+			if (settings.pin_threads) {
+				pin_to_cpu(workers.back(), idx);
+			}
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		ready.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Post(std::function<void()> job) {
+		{
+			std::lock_guard lock(mutex);
+			jobs.push_back(std::move(job));
+		}
+		ready.notify_one();
+	}
+
+	size_t ThreadPool::Size() const noexcept {
+		return workers.size();
+	}
+
+	bool ThreadPool::IsWorkerThread() const noexcept {
+		return current_pool == this;
+	}
+
+	void ThreadPool::work() {
+		current_pool = this;
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock lock(mutex);
+				ready.wait(lock, [this]() {
+					return stopping || !jobs.empty();
+					});
+				if (jobs.empty()) {		//Stopped and drained
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	void configure_default_pool(PoolSettings settings) {
+		default_settings() = settings;
+	}
+
+	ThreadPool& default_pool() {
+		static ThreadPool pool(default_settings());
+		return pool;
+	}
+
+	namespace detail {
+		PageLatch::PageLatch(size_t count) noexcept
+			: pending{ count } {
+		}
+
+		void PageLatch::Wait() {
+			std::unique_lock lock(mutex);
+			done.wait(lock, [this]() {
+				return pending == 0;
+				});
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+		void PageLatch::set_exception(std::exception_ptr exception) noexcept {
+			std::lock_guard lock(mutex);
+			if (!error) {
+				error = exception;
+			}
+		}
+
+		void PageLatch::count_down() noexcept {
+			std::lock_guard lock(mutex);
+			if (--pending == 0) {
+				done.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/*Standart headers*/
+#include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <type_traits>
+
+namespace algo::execution {
+	size_t hardware_thread_count();
+
+	struct PoolSettings {
+		size_t thread_count{ hardware_thread_count() };
+		bool pin_threads{ false };		//Worker i is bound to CPU i (Linux only)
+	};
+
+	/*Long-lived fixed-size set of worker threads with a FIFO submission queue*/
+	class ThreadPool {
+	public:
+		explicit ThreadPool(PoolSettings settings = {});
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/*Runs the queued jobs and joins the workers*/
+		~ThreadPool();
+
+		template <class Task>
+		std::future<std::invoke_result_t<Task>> Submit(Task task) {
+			auto packaged{ std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(std::move(task)) };
+			auto result{ packaged->get_future() };
+			Post([packaged]() {
+				(*packaged)();
+				});
+			return result;
+		}
+
+		/*Fire-and-forget job: it must not throw*/
+		void Post(std::function<void()> job);
+
+		size_t Size() const noexcept;
+
+		/*The calling thread is a worker of this pool (nested parallel work must not wait for it)*/
+		bool IsWorkerThread() const noexcept;
+	private:
+		void work();
+	private:
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<std::function<void()>> jobs;
+		bool stopping{ false };
+		std::vector<std::thread> workers;
+	};
+
+	/*Applied when the shared pool is created, i.e. must be called before the first parallel_for*/
+	void configure_default_pool(PoolSettings settings);
+
+	/*Shared pool behind parallel_for*/
+	ThreadPool& default_pool();
+
+	namespace detail {
+		/*Counts the unfinished pages of parallel_for; the first exception is rethrown by Wait()*/
+		class PageLatch {
+		public:
+			explicit PageLatch(size_t count) noexcept;
+
+			template <class Function>
+			void Run(Function& func) noexcept {
+				try {
+					func();
+				}
+				catch (...) {
+					set_exception(std::current_exception());
+				}
+				count_down();
+			}
+
+			void Wait();
+		private:
+			void set_exception(std::exception_ptr exception) noexcept;
+			void count_down() noexcept;
+		private:
+			std::mutex mutex;
+			std::condition_variable done;
+			size_t pending;
+			std::exception_ptr error;
+		};
+	}
+}
@@ -0,0 +1,69 @@
+#include "work_stealing.h"
+
+#include <algorithm>
+
+namespace algo::execution::detail {
+	StealingRanges::StealingRanges(size_t item_count, size_t participant_count_)
+		: participant_count{ std::max<size_t>(participant_count_, 1) },
+		ranges{ std::make_unique<Range[]>(participant_count) } {
+		for (size_t idx = 0; idx < participant_count; ++idx) {
+			ranges[idx].bounds.store(
+				pack(item_count * idx / participant_count, item_count * (idx + 1) / participant_count),
+				std::memory_order_relaxed
+			);
+		}
+	}
+
+	std::pair<size_t, size_t> StealingRanges::Next(size_t participant) noexcept {
+		std::pair<size_t, size_t> chunk;
+		while (!take_front(participant, chunk)) {
+			if (!steal(participant)) {
+				return { 0, 0 };
+			}
+		}
+		return chunk;
+	}
+
+	bool StealingRanges::take_front(size_t participant, std::pair<size_t, size_t>& chunk) noexcept {
+		auto& bounds{ ranges[participant].bounds };
+		uint64_t current{ bounds.load(std::memory_order_acquire) };
+		while (true) {
+			const size_t begin{ begin_of(current) }, end{ end_of(current) };
+			if (begin >= end) {
+				return false;
+			}
+			/*Guided chunking: large chunks while there is a lot of work, single items at the end*/
+			const size_t grain{ std::max<size_t>((end - begin) / (2 * participant_count), 1) };
+			if (bounds.compare_exchange_weak(current, pack(begin + grain, end), std::memory_order_acq_rel)) {
+				chunk = { begin, begin + grain };
+				return true;
+			}
+		}
+	}
+
+	bool StealingRanges::steal(size_t thief) noexcept {
+		while (true) {
+			size_t victim{ participant_count }, victim_size{ 0 };
+			uint64_t victim_bounds{ 0 };
+			for (size_t idx = 0; idx < participant_count; ++idx) {
+				const uint64_t current{ ranges[idx].bounds.load(std::memory_order_acquire) };
+				const size_t size{ end_of(current) > begin_of(current) ? end_of(current) - begin_of(current) : 0 };
+				if (idx != thief && size > victim_size) {
+					victim = idx;
+					victim_size = size;
+					victim_bounds = current;
+				}
+			}
+			if (victim == participant_count) {
+				return false;
+			}
+
+			const size_t begin{ begin_of(victim_bounds) }, end{ end_of(victim_bounds) },
+				middle{ begin + (end - begin) / 2 };
+			if (ranges[victim].bounds.compare_exchange_strong(victim_bounds, pack(begin, middle), std::memory_order_acq_rel)) {
+				ranges[thief].bounds.store(pack(middle, end), std::memory_order_release);		//The own range is empty: nobody else writes it
+				return true;
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+/*Standart headers*/
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace algo::execution::detail {
+	/*Index ranges of the dynamic_for participants. The owner takes chunks from the front of its range,
+	the chunk size shrinks with the remaining work (down to a single item); an idle participant
+	steals the back half of the fullest range*/
+	class StealingRanges {
+	public:
+		/*Items are split evenly between the participants*/
+		StealingRanges(size_t item_count, size_t participant_count);
+
+		/*The next chunk [first, last) for the participant: from its own range or stolen.
+		An empty chunk means that all the work has been taken*/
+		std::pair<size_t, size_t> Next(size_t participant) noexcept;
+	private:
+		bool take_front(size_t participant, std::pair<size_t, size_t>& chunk) noexcept;
+		bool steal(size_t thief) noexcept;
+	private:
+		/*Both bounds in one word (begin in the high half), so the owner and thieves agree with a single CAS*/
+		struct alignas(64) Range {
+			std::atomic<uint64_t> bounds;
+		};
+
+		static constexpr uint64_t pack(uint64_t begin, uint64_t end) noexcept {
+			return begin << 32 | end;
+		}
+		static constexpr size_t begin_of(uint64_t bounds) noexcept {
+			return static_cast<size_t>(bounds >> 32);
+		}
+		static constexpr size_t end_of(uint64_t bounds) noexcept {
+			return static_cast<size_t>(bounds & 0xFFFFFFFF);
+		}
+	private:
+		size_t participant_count;
+		std::unique_ptr<Range[]> ranges;
+	};
+}
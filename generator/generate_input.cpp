@@ -0,0 +1,32 @@
+#include "network_generator.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/*Writes an input document to the standard output:
+NetworkGenerator <stop count> <bus count> <stat request count> [seed]*/
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		cerr << "Usage: " << argv[0] << " <stop count> <bus count> <stat request count> [seed]" << endl;
+		return 1;
+	}
+	const generator::Parameters parameters{
+		.stop_count = stoul(argv[1]),
+		.bus_count = stoul(argv[2]),
+		.seed = argc > 4 ? static_cast<uint32_t>(stoul(argv[4])) : 1
+	};
+	const size_t stat_count{ stoul(argv[3]) };
+	const generator::StatRequests stat{
+		.buses = stat_count / 4,
+		.stops = stat_count / 4,
+		.routes = stat_count - stat_count / 4 * 2,
+#ifdef RENDER
+		.map = true,
+#endif
+		.seed = parameters.seed
+	};
+	cout << generator::MakeInput(generator::MakeNetwork(parameters), stat);
+	return 0;
+}
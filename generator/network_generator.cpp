@@ -0,0 +1,195 @@
+#include "network_generator.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace std;
+
+namespace generator {
+	string_view Network::AddName(string name) {
+		return names.emplace_back(move(name));
+	}
+
+	Network MakeNetwork(const Parameters& parameters) {
+		mt19937 random(parameters.seed);
+		auto uniform{ [&random](size_t min, size_t max) {
+			return uniform_int_distribution<size_t>(min, max)(random);
+		} };
+		auto real{ [&random](double min, double max) {
+			return uniform_real_distribution<double>(min, max)(random);
+		} };
+
+		Network network;
+		network.stops.reserve(parameters.stop_count);
+		for (size_t stop = 0; stop < parameters.stop_count; ++stop) {
+			network.stops.push_back(geographic::Stop{
+				.name = network.AddName("Stop " + to_string(stop)),
+				.coordinates = { real(55.5, 55.8), real(37.3, 37.7) }
+				});
+		}
+		for (auto& stop : network.stops) {
+			const size_t distance_count{ uniform(0, parameters.max_road_distances) };
+			for (size_t i = 0; i < distance_count; ++i) {
+				const auto& neighbour{ network.stops[uniform(0, parameters.stop_count - 1)] };
+				if (neighbour.name != stop.name) {
+					stop.distances.insert({ neighbour.name, uniform(100, 5000) });
+				}
+			}
+		}
+
+		/*The stops of a route are distinct*/
+		vector<size_t> order(parameters.stop_count);
+		iota(order.begin(), order.end(), size_t{ 0 });
+		network.buses.reserve(parameters.bus_count);
+		for (size_t bus = 0; bus < parameters.bus_count; ++bus) {
+			const size_t route_stops{ min(uniform(2, parameters.max_route_stops), parameters.stop_count) };
+			shuffle(order.begin(), order.end(), random);
+			geographic::Bus route{ .name = network.AddName("Bus " + to_string(bus)), .is_roundtrip = uniform(0, 1) == 1 };
+			for (size_t i = 0; i < route_stops; ++i) {
+				route.stops.push_back(network.stops[order[i]].name);
+			}
+			if (route.is_roundtrip) {
+				route.stops.push_back(route.stops.front());
+			}
+			network.buses.push_back(move(route));
+		}
+		return network;
+	}
+
+	routing::Parameters MakeRoutingSettings() {
+		return routing::Parameters{ .bus_wait_time = 6, .bus_velocity = 40 };
+	}
+
+#ifdef RENDER
+	render::Settings MakeRenderSettings() {
+		return render::Settings{
+			.map = { .width = 1200, .height = 500, .padding = 50 },
+			.route = { .stop_radius = 5, .line_width = 14 },
+			.stop_label = { .font_size = 18, .offset = { 7, -3 } },
+			.bus_label = { .font_size = 20, .offset = { 7, 15 } },
+			.substrate = { .underlayer_width = 3, .underlayer_color = svg::Rgba{ { 255, 255, 255 }, 0.85 } },
+			.palette = { svg::Color(string("red")), svg::Color(string("green")), svg::Rgb{ 255, 160, 0 }, svg::Color(string("purple")) },
+			.layer_sequence = { "bus_lines", "bus_labels", "stop_points", "stop_labels" }
+		};
+	}
+#endif
+
+	namespace {
+		Json::Node make_render_settings() {
+			auto color{ [](uint64_t red, uint64_t green, uint64_t blue) {
+				return Json::array_t{ Json::Number(red), Json::Number(green), Json::Number(blue) };
+			} };
+			auto point{ [](int64_t x, int64_t y) {
+				return Json::array_t{ Json::Number(x), Json::Number(y) };
+			} };
+			Json::array_t underlayer_color(color(255, 255, 255));		//Braces would nest the array
+			underlayer_color.emplace_back(Json::Number(0.85));
+			return Json::map_t{
+				{ "width", Json::Number(uint64_t{ 1200 }) },
+				{ "height", Json::Number(uint64_t{ 500 }) },
+				{ "padding", Json::Number(uint64_t{ 50 }) },
+				{ "stop_radius", Json::Number(uint64_t{ 5 }) },
+				{ "line_width", Json::Number(uint64_t{ 14 }) },
+				{ "stop_label_font_size", Json::Number(uint64_t{ 18 }) },
+				{ "stop_label_offset", point(7, -3) },
+				{ "underlayer_color", move(underlayer_color) },
+				{ "underlayer_width", Json::Number(uint64_t{ 3 }) },
+				{ "color_palette", Json::array_t{
+					Json::string_view_t("red"), Json::string_view_t("green"), color(255, 160, 0), Json::string_view_t("purple")
+				} },
+				{ "bus_label_font_size", Json::Number(uint64_t{ 20 }) },
+				{ "bus_label_offset", point(7, 15) },
+				{ "layers", Json::array_t{
+					Json::string_view_t("bus_lines"), Json::string_view_t("bus_labels"),
+					Json::string_view_t("stop_points"), Json::string_view_t("stop_labels")
+				} }
+			};
+		}
+
+		Json::array_t make_base_requests(const Network& network) {
+			Json::array_t requests;
+			requests.reserve(network.stops.size() + network.buses.size());
+			for (const auto& stop : network.stops) {
+				Json::map_t distances;
+				for (const auto& [neighbour, distance] : stop.distances) {
+					distances.emplace(Json::string_t(neighbour), Json::Number(distance));
+				}
+				requests.emplace_back(Json::map_t{
+					{ "type", Json::string_view_t("Stop") },
+					{ "name", stop.name },
+					{ "latitude", Json::Number(stop.coordinates.latitude) },
+					{ "longitude", Json::Number(stop.coordinates.longitude) },
+					{ "road_distances", move(distances) }
+					});
+			}
+			for (const auto& bus : network.buses) {
+				Json::array_t stops;
+				for (const auto stop : bus.stops) {
+					stops.emplace_back(stop);
+				}
+				requests.emplace_back(Json::map_t{
+					{ "type", Json::string_view_t("Bus") },
+					{ "name", bus.name },
+					{ "stops", move(stops) },
+					{ "is_roundtrip", bus.is_roundtrip }
+					});
+			}
+			return requests;
+		}
+
+		Json::array_t make_stat_requests(const Network& network, const StatRequests& stat) {
+			mt19937 random(stat.seed);
+			auto pick_name{ [&random](const auto& items, bool may_be_unknown) -> string_view {
+				const size_t index{ uniform_int_distribution<size_t>(0, items.size() - (may_be_unknown ? 0 : 1))(random) };
+				return index < items.size() ? items[index].name : "Unknown";
+			} };
+
+			vector<string_view> types;
+			types.insert(types.end(), stat.buses, "Bus");
+			types.insert(types.end(), stat.stops, "Stop");
+			types.insert(types.end(), stat.routes, "Route");
+			shuffle(types.begin(), types.end(), random);
+			if (stat.map) {
+				types.push_back("Map");
+			}
+
+			Json::array_t requests;
+			requests.reserve(types.size());
+			for (const auto type : types) {
+				Json::map_t request{
+					{ "id", Json::Number(static_cast<uint64_t>(requests.size())) },
+					{ "type", type }
+				};
+				if (type == "Bus") {
+					request.emplace("name", pick_name(network.buses, true));
+				}
+				else if (type == "Stop") {
+					request.emplace("name", pick_name(network.stops, true));
+				}
+				else if (type == "Route") {
+					request.emplace("from", pick_name(network.stops, false));		//Route stops must be known
+					request.emplace("to", pick_name(network.stops, false));
+				}
+				requests.emplace_back(move(request));
+			}
+			return requests;
+		}
+	}
+
+	string MakeInput(const Network& network, const StatRequests& stat, Json::Format format) {
+		const auto routing_settings{ MakeRoutingSettings() };
+		const Json::map_t document{
+			{ "routing_settings", Json::map_t{
+				{ "bus_wait_time", Json::Number(routing_settings.bus_wait_time) },
+				{ "bus_velocity", Json::Number(routing_settings.bus_velocity) }
+			} },
+			{ "render_settings", make_render_settings() },
+			{ "base_requests", make_base_requests(network) },
+			{ "stat_requests", make_stat_requests(network, stat) }
+		};
+		string input;
+		Json::Writer(input, format).Write(document);
+		return input;
+	}
+}
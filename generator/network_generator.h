@@ -0,0 +1,61 @@
+#pragma once
+#include "geographic.h"
+#include "routing.h"
+#include "json.h"
+
+#ifdef RENDER
+#include "render.h"
+#endif
+
+/*Standart headers*/
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*Synthetic transport networks for the tests and the benchmarks: the same parameters give the same network*/
+namespace generator {
+	struct Parameters {
+		size_t stop_count{ 30 };
+		size_t bus_count{ 10 };
+		size_t max_route_stops{ 8 };										//At least 2
+		size_t max_road_distances{ 3 };										//Per stop
+		uint32_t seed{ 1 };
+	};
+
+	/*Stops and buses in the form of base requests (a round trip ends with its first stop).
+	The names are owned by the network, so it can be moved but not copied*/
+	struct Network {
+		std::deque<std::string> names;										//Deque keeps the views valid
+		std::vector<geographic::Stop> stops;
+		std::vector<geographic::Bus> buses;
+
+		Network() = default;
+		Network(Network&&) = default;
+		Network& operator=(Network&&) = default;
+		Network(const Network&) = delete;
+		Network& operator=(const Network&) = delete;
+
+		std::string_view AddName(std::string name);
+	};
+
+	Network MakeNetwork(const Parameters& parameters);
+
+	routing::Parameters MakeRoutingSettings();
+#ifdef RENDER
+	render::Settings MakeRenderSettings();
+#endif
+
+	/*Stat requests of the input document: names are taken at random, a few Bus and Stop names are unknown*/
+	struct StatRequests {
+		size_t buses{ 0 };
+		size_t stops{ 0 };
+		size_t routes{ 0 };
+		bool map{ false };
+		uint32_t seed{ 1 };
+	};
+
+	/*Input document of the program: the settings above, the network as base_requests and the stat requests*/
+	std::string MakeInput(const Network& network, const StatRequests& stat, Json::Format format = Json::Format::PRETTY);
+}
@@ -1,4 +1,12 @@
 #include "earth.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GEOGRAPHIC_AVX2
+#endif
 using namespace std;
 
 namespace geographic {
@@ -9,4 +17,96 @@ namespace geographic {
 			cos(abs(degrees_to_radians(first.longitude) - degrees_to_radians(second.longitude)))
 		) * earth_radius;
 	}
-}
\ No newline at end of file
+
+	void TrigTable::Assign(const vector<Coordinates>& coordinates) {
+		latitude_sin.clear();
+		latitude_cos.clear();
+		longitude_sin.clear();
+		longitude_cos.clear();
+		latitude_sin.reserve(coordinates.size());
+		latitude_cos.reserve(coordinates.size());
+		longitude_sin.reserve(coordinates.size());
+		longitude_cos.reserve(coordinates.size());
+		for (const auto point : coordinates) {
+			PushBack(point);
+		}
+	}
+
+	void TrigTable::PushBack(Coordinates coordinates) {
+		latitude_sin.push_back(sin(degrees_to_radians(coordinates.latitude)));
+		latitude_cos.push_back(cos(degrees_to_radians(coordinates.latitude)));
+		longitude_sin.push_back(sin(degrees_to_radians(coordinates.longitude)));
+		longitude_cos.push_back(cos(degrees_to_radians(coordinates.longitude)));
+	}
+
+	void TrigTable::Set(size_t idx, Coordinates coordinates) {
+		latitude_sin[idx] = sin(degrees_to_radians(coordinates.latitude));
+		latitude_cos[idx] = cos(degrees_to_radians(coordinates.latitude));
+		longitude_sin[idx] = sin(degrees_to_radians(coordinates.longitude));
+		longitude_cos[idx] = cos(degrees_to_radians(coordinates.longitude));
+	}
+
+	size_t TrigTable::Size() const noexcept {
+		return latitude_sin.size();
+	}
+
+	void calc_distances(
+		const TrigTable& table,
+		span<const uint32_t> from,
+		span<const uint32_t> to,
+		span<double> distances
+	) {
+		assert(from.size() == to.size() && from.size() == distances.size());
+		size_t idx{ 0 };
+
+		/*The cosine of the central angle is clamped: rounding can put it out of [-1, 1] for close points*/
+#ifdef GEOGRAPHIC_AVX2
+		const __m256d lower{ _mm256_set1_pd(-1.0) },
+			upper{ _mm256_set1_pd(1.0) };
+		for (; idx + 4 <= from.size(); idx += 4) {
+			const __m128i first{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(from.data() + idx)) },
+				second{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(to.data() + idx)) };
+			const __m256d longitude_cos{ _mm256_add_pd(
+				_mm256_mul_pd(
+					_mm256_i32gather_pd(table.longitude_cos.data(), first, 8),
+					_mm256_i32gather_pd(table.longitude_cos.data(), second, 8)
+				),
+				_mm256_mul_pd(
+					_mm256_i32gather_pd(table.longitude_sin.data(), first, 8),
+					_mm256_i32gather_pd(table.longitude_sin.data(), second, 8)
+				)
+			) };
+			const __m256d angle_cos{ _mm256_add_pd(
+				_mm256_mul_pd(
+					_mm256_i32gather_pd(table.latitude_sin.data(), first, 8),
+					_mm256_i32gather_pd(table.latitude_sin.data(), second, 8)
+				),
+				_mm256_mul_pd(
+					_mm256_mul_pd(
+						_mm256_i32gather_pd(table.latitude_cos.data(), first, 8),
+						_mm256_i32gather_pd(table.latitude_cos.data(), second, 8)
+					),
+					longitude_cos
+				)
+			) };
+			_mm256_storeu_pd(distances.data() + idx, _mm256_min_pd(_mm256_max_pd(angle_cos, lower), upper));
+			for (size_t lane = idx; lane < idx + 4; ++lane) {
+				distances[lane] = acos(distances[lane]) * earth_radius;
+			}
+		}
+#endif
+		for (; idx < from.size(); ++idx) {
+			const uint32_t first{ from[idx] },
+				second{ to[idx] };
+			const double longitude_cos{
+				table.longitude_cos[first] * table.longitude_cos[second] +
+				table.longitude_sin[first] * table.longitude_sin[second]
+			};
+			const double angle_cos{
+				table.latitude_sin[first] * table.latitude_sin[second] +
+				table.latitude_cos[first] * table.latitude_cos[second] * longitude_cos
+			};
+			distances[idx] = acos(clamp(angle_cos, -1.0, 1.0)) * earth_radius;
+		}
+	}
+}
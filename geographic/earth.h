@@ -1,6 +1,9 @@
 #pragma once
 #include "geographic.h"
 #include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
 
 namespace geographic {
 	/*Constants section*/
@@ -26,4 +29,36 @@ namespace geographic {
 		Coordinates first,
 		Coordinates second
 	);
+
+	/*Sines and cosines of the latitudes and longitudes (struct of arrays), computed once per point.
+	cos(a - b) = cos(a) * cos(b) + sin(a) * sin(b), so a distance needs no trigonometry but acos*/
+	class TrigTable {
+	public:
+		void Assign(const std::vector<Coordinates>& coordinates);
+		void PushBack(Coordinates coordinates);
+		void Set(size_t idx, Coordinates coordinates);
+		size_t Size() const noexcept;
+	private:
+		friend void calc_distances(
+			const TrigTable& table,
+			std::span<const uint32_t> from,
+			std::span<const uint32_t> to,
+			std::span<double> distances
+		);
+	private:
+		std::vector<double>
+			latitude_sin,
+			latitude_cos,
+			longitude_sin,
+			longitude_cos;
+	};
+
+	/*distances[i] is the distance between the points from[i] and to[i] of the table.
+	Four pairs per step with AVX2 (-mavx2), scalar otherwise*/
+	void calc_distances(
+		const TrigTable& table,
+		std::span<const uint32_t> from,
+		std::span<const uint32_t> to,
+		std::span<double> distances
+	);
 }
\ No newline at end of file
@@ -1,136 +1,611 @@
 #include "json.h"
+#include "json_scanner.h"
+#include "execution.h"
 #include <algorithm>
+#include <charconv>
+#include <limits>
 
 using namespace std;
 
 namespace Json {
 
-    Document::Document(Node root) : root(move(root)) {
+    Document::Document(Node root) 
+        : root{ new Node(move(root)), NodeDeleter{} } {
+    }
+
+    Document::Document(unique_ptr<Arena> arena_, Node root_)
+        : arena{ move(arena_) },
+        root{ pmr::polymorphic_allocator<Node>(arena.get()).new_object<Node>(move(root_)), NodeDeleter{ false } } {
+    }
+
+    Document::Document(unique_ptr<Arena> arena_, vector<unique_ptr<Arena>> chunk_arenas_, Node root_)
+        : Document(move(arena_), move(root_)) {
+        chunk_arenas = move(chunk_arenas_);
     }
 
     const Node& Document::GetRoot() const {
-        return root;
+        return *root;
+    }
+
+    void Document::NodeDeleter::operator()(Node* node) const noexcept {
+        if (owner) {
+            delete node;
+        }
     }
 
-    Node LoadNode(string_view& input);
+    /*State of the JSON Tree loading*/
+    struct LoadContext {
+        pmr::memory_resource* resource;
+        bool in_place;                              //Strings without escape sequences are views into the input
+        bool parallel{ false };                     //Top-level arrays are parsed in chunks
+        size_t depth{ 0 };
+        string_t scratch{};                         //Decoded escape sequences
+        vector<unique_ptr<Arena>> chunk_arenas{};   //Memory of the chunks parsed in parallel
+    };
+
+    Node LoadNode(string_view& input, LoadContext& context);
+
+    /*Removes leading spaces, commas and colons*/
+    void SkipService(string_view& input) noexcept {
+        input.remove_prefix(scanner::SkipService(input));
+    }
 
-    Node LoadArray(string_view& input) {
-        vector<Node> result;
+    Node LoadArray(string_view& input, LoadContext& context) {
+        array_t result(context.resource);
 
         char ch{ ch = input.front() };
         input.remove_prefix(1);
+        SkipService(input);
 
+        ++context.depth;
         while ((ch = input.front()) != ']') {
             input.remove_prefix(ch == ',' || ch == ':');
-            result.push_back(LoadNode(input));
+            result.push_back(LoadNode(input, context));
         }
+        --context.depth;
 
         input.remove_prefix(1);
-        input = algo::string::Strict(input, IsService);
+        SkipService(input);
 
         return Node(move(result));
     }
 
-    struct smart_uint64_t {
-        uint64_t value{ 0 };
-        size_t  length{ 0 };
+    /*Length of the string token (the input starts with the opening quote)*/
+    size_t SkipString(string_view input) {
+        for (size_t pos = 1; ; pos += 2) {      //Skips the escaped character
+            pos += scanner::FindQuoteOrEscape(input.substr(pos));
+            if (pos >= input.length()) {
+                throw invalid_argument("Json: unterminated string");
+            }
+            if (input[pos] == '\"') {
+                return pos + 1;
+            }
+        }
+    }
+
+    /*Length of the value token. Brackets of containers are counted outside strings only*/
+    size_t SkipValue(string_view input) {
+        if (input.front() == '\"') {
+            return SkipString(input);
+        }
+        if (input.front() != '[' && input.front() != '{') {
+            size_t pos{ 0 };
+            for (; pos < input.length() && !scanner::IsService(input[pos]) && input[pos] != ']' && input[pos] != '}'; ++pos);
+            return pos;
+        }
+
+        size_t depth{ 0 }, pos{ 0 };
+        do {
+            pos += scanner::FindStructural(input.substr(pos));
+            if (pos >= input.length()) {
+                throw invalid_argument("Json: unterminated container");
+            }
+            const char ch{ input[pos] };
+            if (ch == '\"') {
+                pos += SkipString(input.substr(pos));
+                continue;
+            }
+            depth = ch == '[' || ch == '{' ? depth + 1 : depth - 1;
+            ++pos;
+        } while (depth);
+        return pos;
+    }
+
+    /*Structural pre-scan: bounds of the array elements (the array is removed from the input)*/
+    vector<string_view> ScanArray(string_view& input) {
+        vector<string_view> elements;
+        input.remove_prefix(1);
+        SkipService(input);
+
+        while (input.front() != ']') {
+            const size_t length{ SkipValue(input) };
+            elements.push_back(input.substr(0, length));
+            input.remove_prefix(length);
+            SkipService(input);
+        }
+
+        input.remove_prefix(1);
+        SkipService(input);
+        return elements;
+    }
+
+    /*Consecutive elements parsed by one worker into its own arena*/
+    struct Chunk {
+        string_view text;
+        size_t count;
+        unique_ptr<Arena> arena;
+        optional<array_t> nodes;
     };
 
-    /*string to uint64_t conversion*/
-    smart_uint64_t ReadUInt64(string_view& input, optional<uint64_t> max_length = nullopt) {
-        smart_uint64_t number;
-        for (char ch; (!max_length || number.length < max_length) && isdigit(ch = input.front()); ++number.length) {
-            number.value *= 10;
-            number.value += static_cast<uint64_t>(ch) - '0';
-            input.remove_prefix(1);
+    /*The array is split into chunks of whole elements of about the same size (a few chunks per thread
+    to balance the load); the parsed chunks are joined in order without copying the subtrees*/
+    Node LoadArrayParallel(string_view& input, LoadContext& context) {
+        static constexpr size_t min_chunk_size{ 1 << 16 }, chunks_per_thread{ 4 };
+
+        const vector<string_view> elements{ ScanArray(input) };
+        array_t result(context.resource);
+        if (elements.empty()) {
+            return Node(move(result));
+        }
+
+        const char* const first{ elements.front().data() };
+        const size_t text_size{ static_cast<size_t>(elements.back().data() + elements.back().size() - first) },
+            chunk_count{ min(algo::execution::hardware_thread_count() * chunks_per_thread, text_size / min_chunk_size) };
+
+        if (chunk_count < 2) {
+            string_view text(first, text_size);
+            result.reserve(elements.size());
+            ++context.depth;
+            while (!text.empty()) {
+                result.push_back(LoadNode(text, context));
+            }
+            --context.depth;
+            return Node(move(result));
+        }
+
+        vector<Chunk> chunks;
+        chunks.reserve(chunk_count);
+        const size_t chunk_size{ text_size / chunk_count };
+        for (auto it = elements.begin(); it != elements.end(); ) {
+            const char* const chunk_first{ it->data() };
+            auto last{ it };
+            for (; last != elements.end() && static_cast<size_t>(last->data() - chunk_first) < chunk_size; ++last);
+            const string_view& back{ *prev(last) };
+            chunks.push_back(Chunk{
+                .text = string_view(chunk_first, static_cast<size_t>(back.data() + back.size() - chunk_first)),
+                .count = static_cast<size_t>(last - it),
+                .arena = nullptr,
+                .nodes = nullopt
+                });
+            it = last;
         }
-        return number;
+
+        algo::execution::parallel_for(chunks.begin(), chunks.end(),
+            [in_place = context.in_place](Chunk& chunk) {
+                chunk.arena = make_unique<Arena>(in_place ? chunk.text.size() / 2 : chunk.text.size());
+                LoadContext chunk_context{ .resource = chunk.arena.get(), .in_place = in_place, .depth = 1 };
+                auto& nodes{ chunk.nodes.emplace(chunk_context.resource) };
+                nodes.reserve(chunk.count);
+                for (string_view text{ chunk.text }; !text.empty(); ) {
+                    nodes.push_back(LoadNode(text, chunk_context));
+                }
+            });
+
+        result.reserve(elements.size());
+        for (auto& chunk : chunks) {
+            move(chunk.nodes->begin(), chunk.nodes->end(), back_inserter(result));
+            context.chunk_arenas.push_back(move(chunk.arena));
+        }
+        return Node(move(result));
     }
 
-    Node LoadNumber(string_view& input) {
-        input = algo::string::Strict(input, IsService);
+    /*Powers of ten that are exactly representable as double*/
+    constexpr auto MakeExactPowers() noexcept {
+        array<double, 23> powers{ 1.0 };
+        for (size_t idx = 1; idx < powers.size(); ++idx) {
+            powers[idx] = powers[idx - 1] * 10.0;
+        }
+        return powers;
+    }
 
-        NumberHolder number;
-        input.remove_prefix(number.negative = (input.front() == '-'));
+    /*Decimal to double conversion with a single rounding: the fast path for mantissas up to 2^53
+    and exponents up to 10^22 (Clinger), otherwise std::from_chars (Eisel-Lemire in libstdc++)*/
+    double DecimalToDouble(uint64_t mantissa, size_t significant_digits, int64_t exponent, string_view token) {
+        static constexpr auto exact_powers{ MakeExactPowers() };
+        static constexpr uint64_t max_exact_mantissa{ uint64_t{ 1 } << numeric_limits<double>::digits };
+        static constexpr int64_t max_exact_exponent{ static_cast<int64_t>(exact_powers.size()) - 1 };
+
+        const bool negative{ token.front() == '-' };
+        if (significant_digits <= numeric_limits<uint64_t>::digits10 && mantissa <= max_exact_mantissa
+            && exponent >= -max_exact_exponent && exponent <= max_exact_exponent) {
+            double value{ static_cast<double>(mantissa) };
+            value = exponent < 0 ?
+                value / exact_powers[static_cast<size_t>(-exponent)] : value * exact_powers[static_cast<size_t>(exponent)];
+            return negative ? -value : value;
+        }
 
-        number.whole = ReadUInt64(input).value;
+        double value{ 0 };
+        if (from_chars(token.data(), token.data() + token.size(), value).ec == errc::result_out_of_range) {
+            const bool overflow{ static_cast<int64_t>(significant_digits) + exponent > 0 };
+            value = overflow ? numeric_limits<double>::infinity() : 0.0;
+            value = negative ? -value : value;
+        }
+        return value;
+    }
 
-        input.remove_prefix(input.front() == '.');
-        auto [fractional, fractional_length] {ReadUInt64(input, NumberHolder::precision)};
-        number.fractional = fractional;
-        number.fractional_length = fractional_length;
+    /*Accumulates digits (the value is valid while significant_digits <= 19)*/
+    void AccumulateDigits(string_view digits, uint64_t* mantissa, size_t* significant_digits) noexcept {
+        for (char ch : digits) {
+            *significant_digits += (*mantissa || ch != '0');        //Leading zeros aren't significant
+            *mantissa = *mantissa * 10 + static_cast<uint64_t>(ch - '0');
+        }
+    }
+
+    Number ReadNumber(string_view& input) {
+        SkipService(input);
+        const char* const token_begin{ input.data() };
+
+        const bool negative{ input.front() == '-' };
+        input.remove_prefix(negative);
 
-        /*If the length of the fractional part
-        is more than the max accuracy,
-        we need to remove the extra characters*/
-        ReadUInt64(input);
+        uint64_t mantissa{ 0 };
+        size_t significant_digits{ 0 };
+        int64_t exponent{ 0 };
+        bool integral{ true };
 
-        input = algo::string::Strict(input, IsService);
-        return Node(Number(number));
+        const size_t whole_length{ scanner::CountDigits(input) };
+        AccumulateDigits(input.substr(0, whole_length), &mantissa, &significant_digits);
+        input.remove_prefix(whole_length);
+
+        if (!input.empty() && input.front() == '.') {
+            input.remove_prefix(1);
+            const size_t fractional_length{ scanner::CountDigits(input) };
+            AccumulateDigits(input.substr(0, fractional_length), &mantissa, &significant_digits);
+            input.remove_prefix(fractional_length);
+            exponent -= static_cast<int64_t>(fractional_length);
+            integral = false;
+        }
+
+        if (!input.empty() && (input.front() == 'e' || input.front() == 'E')) {
+            input.remove_prefix(1);
+            const bool negative_exponent{ input.front() == '-' };
+            input.remove_prefix(input.front() == '-' || input.front() == '+');
+
+            /*Saturation: larger exponents give zero or infinity anyway*/
+            static constexpr int64_t exponent_limit{ 100'000 };
+            int64_t explicit_exponent{ 0 };
+            const size_t exponent_length{ scanner::CountDigits(input) };
+            for (char ch : input.substr(0, exponent_length)) {
+                explicit_exponent = min(explicit_exponent * 10 + (ch - '0'), exponent_limit);
+            }
+            input.remove_prefix(exponent_length);
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+            integral = false;
+        }
+
+        const string_view token(token_begin, static_cast<size_t>(input.data() - token_begin));
+        SkipService(input);
+
+        /*Integers are stored exactly*/
+        static constexpr uint64_t max_negative{ uint64_t{ 1 } << (numeric_limits<int64_t>::digits) };
+        if (integral && significant_digits <= numeric_limits<uint64_t>::digits10) {
+            if (!negative) {
+                return Number(mantissa);
+            }
+            if (mantissa <= max_negative) {
+                return Number(static_cast<int64_t>(0 - mantissa));
+            }
+        }
+        return Number(DecimalToDouble(mantissa, significant_digits, exponent, token));
     }
 
-    Node LoadBool(string_view& input) {
-        input = algo::string::Strict(input, IsService);
+    bool ReadBool(string_view& input) {
+        SkipService(input);
         static constexpr string_view true_cond{ "true" },
             false_cond{ "false" };
 
-        if (input.substr(0, true_cond.length()) == true_cond) {
-            input.remove_prefix(true_cond.length());
-            input = algo::string::Strict(input, IsService);
-            return Node(true);
+        const bool value{ input.substr(0, true_cond.length()) == true_cond };
+        input.remove_prefix(value ? true_cond.length() : false_cond.length());
+        SkipService(input);
+        return value;
+    }
+
+    /*Four hex digits of the \\u escape sequence*/
+    uint32_t ReadHex4(string_view& input) {
+        static constexpr size_t length{ 4 };
+        uint32_t value{ 0 };
+        const auto [ptr, error] { from_chars(input.data(), input.data() + min(length, input.length()), value, 16) };
+        if (error != errc{} || ptr != input.data() + length) {
+            throw invalid_argument("Json: invalid \\u escape sequence");
+        }
+        input.remove_prefix(length);
+        return value;
+    }
+
+    void AppendUtf8(uint32_t code_point, string_t& output) {
+        if (code_point < 0x80) {
+            output += static_cast<char>(code_point);
+        }
+        else if (code_point < 0x800) {
+            output += static_cast<char>(0xC0 | (code_point >> 6));
+            output += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else if (code_point < 0x10000) {
+            output += static_cast<char>(0xE0 | (code_point >> 12));
+            output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            output += static_cast<char>(0x80 | (code_point & 0x3F));
         }
         else {
-            input.remove_prefix(false_cond.length());
-            input = algo::string::Strict(input, IsService);
-            return Node(false);
+            output += static_cast<char>(0xF0 | (code_point >> 18));
+            output += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            output += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    /*Decodes one escape sequence (the input starts with the backslash).
+    Unpaired UTF-16 surrogates are replaced with U+FFFD*/
+    void DecodeEscape(string_view& input, string_t& output) {
+        if (input.length() < 2) {
+            throw invalid_argument("Json: unterminated escape sequence");
+        }
+        const char ch{ input[1] };
+        input.remove_prefix(2);
+
+        switch (ch) {
+        case '\"': case '\\': case '/': output += ch; return;
+        case 'b': output += '\b'; return;
+        case 'f': output += '\f'; return;
+        case 'n': output += '\n'; return;
+        case 'r': output += '\r'; return;
+        case 't': output += '\t'; return;
+        case 'u': break;
+        default: throw invalid_argument("Json: invalid escape sequence");
+        }
+
+        static constexpr uint32_t high_surrogate{ 0xD800 }, low_surrogate{ 0xDC00 }, surrogates_end{ 0xE000 },
+            replacement{ 0xFFFD };
+        uint32_t code_point{ ReadHex4(input) };
+        if (code_point >= low_surrogate && code_point < surrogates_end) {
+            code_point = replacement;
+        }
+        else if (code_point >= high_surrogate && code_point < low_surrogate) {
+            string_view next{ input.substr(min<size_t>(2, input.length())) };
+            if (input.substr(0, 2) == "\\u") {
+                if (const uint32_t low{ ReadHex4(next) }; low >= low_surrogate && low < surrogates_end) {
+                    code_point = 0x10000 + ((code_point - high_surrogate) << 10) + (low - low_surrogate);
+                    input = next;
+                }
+                else {
+                    code_point = replacement;       //The next sequence is decoded separately
+                }
+            }
+            else {
+                code_point = replacement;
+            }
         }
+        AppendUtf8(code_point, output);
     }
 
-    Node LoadString(string_view& input) {
-        input = algo::string::Strict(input, IsService);
+    /*Returns a view into the input or (if the string has escape sequences) into the decoded scratch buffer*/
+    string_view ReadString(string_view& input, string_t& scratch) {
+        SkipService(input);
 
         input.remove_prefix(1); //Remove the opening quote
-        string str(input.substr(0, input.find_first_of('"')));
-        input.remove_prefix(str.length() + 1);  //Removes str and closing quote
+        size_t length{ scanner::FindQuoteOrEscape(input) };
+        string_view str{ input.substr(0, length) };
+        input.remove_prefix(length);
+
+        if (!input.empty() && input.front() == '\\') {
+            scratch.assign(str);
+            while (input.empty() || input.front() != '\"') {
+                if (input.empty()) {
+                    throw invalid_argument("Json: unterminated string");
+                }
+                if (input.front() == '\\') {
+                    DecodeEscape(input, scratch);
+                }
+                else {
+                    length = scanner::FindQuoteOrEscape(input);
+                    scratch.append(input.substr(0, length));
+                    input.remove_prefix(length);
+                }
+            }
+            str = scratch;
+        }
+        input.remove_prefix(1);  //Remove the closing quote
 
-        input = algo::string::Strict(input, IsService);
+        SkipService(input);
         return str;
     }
 
-    Node LoadDict(string_view& input) {
-        map_t result;
+    Node LoadNumber(string_view& input) {
+        return Node(ReadNumber(input));
+    }
+
+    Node LoadBool(string_view& input) {
+        return Node(ReadBool(input));
+    }
+
+    Node LoadString(string_view& input, LoadContext& context) {
+        const string_view str{ ReadString(input, context.scratch) };
+        if (context.in_place && str.data() != context.scratch.data()) {     //Not decoded: str is a part of the input
+            return Node(string_view_t(str));
+        }
+        return Node(string_t(str, context.resource));
+    }
+
+    Node LoadDict(string_view& input, LoadContext& context) {
+        map_t result(context.resource);
 
         input.remove_prefix(1);
+        SkipService(input);
 
         for (char ch; (ch = input.front()) != '}'; ) {
-            string key = LoadString(input).AsString();
-            result.emplace(move(key), LoadNode(input));
+            string_t key(ReadString(input, context.scratch), context.resource);
+            ++context.depth;
+            result.emplace(move(key), LoadNode(input, context));
+            --context.depth;
         }
         input.remove_prefix(1);
-        input = algo::string::Strict(input, IsService);
+        SkipService(input);
 
         return Node(move(result));
     }
 
-    Node LoadNode(string_view& input) {
-        input = algo::string::Strict(input, IsService);
+    Node LoadNode(string_view& input, LoadContext& context) {
+        SkipService(input);
         char ch{ input.front() };
 
         switch (ch) {
-        case '[': return LoadArray(input);
-        case '{': return LoadDict(input);
-        case '\"': return LoadString(input);
+        case '[': return context.parallel && context.depth <= 1 ?       //The root array or a root member
+            LoadArrayParallel(input, context) : LoadArray(input, context);
+        case '{': return LoadDict(input, context);
+        case '\"': return LoadString(input, context);
         default: return isalpha(ch) ?
             LoadBool(input) : LoadNumber(input);
         };
     }
 
-    Document Load(string_view input) {
-        return Document{ LoadNode(input) };
+    Document LoadDocument(string_view input, bool in_place, Parsing parsing) {
+        /*The tree is usually not larger than the input (and much smaller without string copies).
+        Chunks parsed in parallel have their own arenas*/
+        const size_t tree_size{ max<size_t>(in_place ? input.size() / 2 : input.size(), 1) };
+        auto arena{ parsing == Parsing::PARALLEL ? make_unique<Arena>() : make_unique<Arena>(tree_size) };
+        LoadContext context{ .resource = arena.get(), .in_place = in_place, .parallel = parsing == Parsing::PARALLEL };
+        Node root{ LoadNode(input, context) };
+        return Document{ move(arena), move(context.chunk_arenas), move(root) };
+    }
+
+    Document Load(string_view input, Parsing parsing) {
+        return LoadDocument(input, false, parsing);
+    }
+
+    Document LoadInPlace(string_view input, Parsing parsing) {
+        return LoadDocument(input, true, parsing);
+    }
+
+    void ParseNode(string_view& input, ISaxHandler& handler, string_t& scratch);
+
+    void ParseArray(string_view& input, ISaxHandler& handler, string_t& scratch) {
+        handler.OnArrayStart();
+        input.remove_prefix(1);
+        SkipService(input);
+
+        while (input.front() != ']') {
+            ParseNode(input, handler, scratch);
+        }
+
+        input.remove_prefix(1);
+        SkipService(input);
+        handler.OnArrayEnd();
+    }
+
+    void ParseDict(string_view& input, ISaxHandler& handler, string_t& scratch) {
+        handler.OnObjectStart();
+        input.remove_prefix(1);
+        SkipService(input);
+
+        while (input.front() != '}') {
+            handler.OnKey(ReadString(input, scratch));
+            ParseNode(input, handler, scratch);
+        }
+
+        input.remove_prefix(1);
+        SkipService(input);
+        handler.OnObjectEnd();
+    }
+
+    void ParseNode(string_view& input, ISaxHandler& handler, string_t& scratch) {
+        SkipService(input);
+        char ch{ input.front() };
+
+        switch (ch) {
+        case '[': ParseArray(input, handler, scratch); break;
+        case '{': ParseDict(input, handler, scratch); break;
+        case '\"': handler.OnString(ReadString(input, scratch)); break;
+        default:
+            if (isalpha(ch)) {
+                handler.OnBool(ReadBool(input));
+            }
+            else {
+                handler.OnNumber(ReadNumber(input));
+            }
+        };
+    }
+
+    void Parse(string_view input, ISaxHandler& handler) {
+        string_t scratch;
+        ParseNode(input, handler, scratch);
+    }
+
+    Builder::Builder(pmr::memory_resource* resource_) noexcept
+        : resource{ resource_ } {
+    }
+
+    void Builder::OnObjectStart() {
+        stack.emplace_back(map_t(resource));
+    }
+
+    void Builder::OnObjectEnd() {
+        close_container();
+    }
+
+    void Builder::OnArrayStart() {
+        stack.emplace_back(array_t(resource));
+    }
+
+    void Builder::OnArrayEnd() {
+        close_container();
+    }
+
+    void Builder::OnKey(string_view key) {
+        keys.emplace_back(key, resource);
+    }
+
+    void Builder::OnString(string_view value) {
+        add_value(Node(string_t(value, resource)));
+    }
+
+    void Builder::OnNumber(Number value) {
+        add_value(Node(value));
+    }
+
+    void Builder::OnBool(bool value) {
+        add_value(Node(value));
+    }
+
+    bool Builder::IsComplete() const noexcept {
+        return stack.empty() && root.has_value();
+    }
+
+    Node Builder::Extract() {
+        Node result{ move(*root) };
+        root.reset();
+        return result;
+    }
+
+    void Builder::close_container() {
+        Node container{ move(stack.back()) };
+        stack.pop_back();
+        add_value(move(container));
+    }
+
+    void Builder::add_value(Node value) {
+        if (stack.empty()) {
+            root = move(value);
+        }
+        else if (auto* array = get_if<array_t>(addressof(stack.back()))) {
+            array->push_back(move(value));
+        }
+        else {
+            get<map_t>(stack.back()).emplace(move(keys.back()), move(value));
+            keys.pop_back();
+        }
     }
 
     bool IsService(char ch) {
-        return isspace(ch) || ch == ',' || ch == ':';
+        return scanner::IsService(ch);
     }
 
     string Read(istream& input) {
@@ -144,86 +619,237 @@ namespace Json {
         return parsed;
     }
 
-    template <class NodeTy>
-    string SerializeNode(const Node& node);
+    Writer::Writer(string& buffer_, Format format_, optional<int> precision_) 
+        : buffer{ buffer_ }, format{ format_ }, precision{ precision_ } {
+    }
 
-    template <>
-    string SerializeNode<bool_t>(const Node& node) {
-        return node.AsBool() ? "true" : "false";
+    Writer::Writer(ostream& output_, Format format_, optional<int> precision_)
+        : buffer{ own_buffer }, output{ addressof(output_) }, format{ format_ }, precision{ precision_ } {
+        own_buffer.reserve(flush_threshold + flush_threshold / 2);
     }
 
-    template <>
-    string SerializeNode<number_t>(const Node& node) {
-        const auto& number{ node.AsNumber() };
-        string result;
-        result.reserve(2 * Number::GetMaxPrecision() + 2);  //Whole, fractional, point and minus
+    void Writer::Write(const Node& node) {
+        if (!output) {
+            buffer.reserve(buffer.size() + EstimateSize(node));
+        }
+        write_node(node);
+        flush();
+    }
 
-        if (number.IsNegative()) {
-            result.push_back('-');
+    void Writer::Write(const array_t& array) {
+        if (!output) {
+            buffer.reserve(buffer.size() + EstimateSize(array));
         }
-        result += algo::string::number_to_string(number.GetWhole());
-        if (number.GetFractionalLength()) {
-            result.push_back('.');
-            result += algo::string::number_to_string(
-                number.GetFractional(),
-                number.GetFractionalLength()
-            );
+        write_array(array);
+        flush();
+    }
+
+    void Writer::Write(const map_t& dict) {
+        if (!output) {
+            buffer.reserve(buffer.size() + EstimateSize(dict));
         }
-        return result;
+        write_dict(dict);
+        flush();
+    }
+
+    void Writer::write_node(const Node& node) {
+        visit(
+            [this](const auto& value) {
+                write_value(value);
+            },
+            node.GetBase()
+        );
+    }
+
+    void Writer::write_value(bool_t value) {
+        buffer += value ? "true" : "false";
+    }
+
+    void Writer::write_value(const number_t& number) {
+        array<char, 64> digits;
+        char* const first{ digits.data() };
+        char* const last_bound{ first + digits.size() };
+
+        char* const last{ number.Visit(
+            [this, first, last_bound](auto value) -> char* {
+                if constexpr (is_floating_point_v<decltype(value)>) {
+                    if (!isfinite(value)) {
+                        return nullptr;
+                    }
+                    if (precision) {
+                        if (auto [ptr, error] = to_chars(first, last_bound, value, chars_format::fixed, *precision);
+                            error == errc{}) {
+                            return ptr;
+                        }
+                    }
+                }
+                return to_chars(first, last_bound, value).ptr;      //Shortest round-trip representation
+            }
+        ) };
+
+        if (!last) {
+            buffer += "null";       //JSON has no infinities and NaNs
+        }
+        else {
+            buffer.append(first, last);
+        }
+    }
+
+    void Writer::write_value(const string_t& str) {
+        write_string(str);
     }
 
-    template <>
-    string SerializeNode<string_t>(const Node& node) {
-        return '\"' + node.AsString() + '\"';
+    void Writer::write_value(string_view_t str) {
+        write_string(str);
     }
 
-    template <>
-    string SerializeNode<array_t>(const Node& node) {
-        string serialized_array{ "[\n" };
-        const auto& array_data{ node.AsArray() };
+    void Writer::write_value(const array_t& array) {
+        write_array(array);
+    }
+
+    void Writer::write_value(const map_t& dict) {
+        write_dict(dict);
+    }
+
+    void Writer::write_value(const verbatim_t& verbatim) {
+        buffer += verbatim.text;
+    }
+
+    void Writer::write_array(const array_t& array_data) {
+        buffer += '[';
+        new_line();
         bool first = true;
 
-        for (auto node_it = array_data.begin(); node_it != array_data.end(); ++node_it) {
+        for (const auto& node : array_data) {
             if (!first) {
-                serialized_array += ",\n";
+                buffer += ',';
+                new_line();
             }
             first = false;
-            serialized_array += SerializeNode<Node>(*node_it);
+            write_node(node);
+            flush_if_full();
         }
-
-        return serialized_array += "\n]";
+        new_line();
+        buffer += ']';
     }
 
-    template <>
-    string SerializeNode<map_t>(const Node& node) {
-        string serialized_dict{ "{\n" };
-        const auto& dict_data{ node.AsMap() };
+    void Writer::write_dict(const map_t& dict_data) {
+        buffer += '{';
+        new_line();
         bool first = true;
 
-        for (auto node_it = dict_data.begin(); node_it != dict_data.end(); ++node_it) {
+        for (const auto& [key, node] : dict_data) {
             if (!first) {
-                serialized_dict += ",\n";
+                buffer += ',';
+                new_line();
             }
             first = false;
-            serialized_dict += '\"' + node_it->first + "\": ";
-            serialized_dict += SerializeNode<Node>(node_it->second);
+            write_string(key);
+            buffer += format == Format::PRETTY ? ": " : ":";
+            write_node(node);
         }
-        return serialized_dict += "\n}";
+        new_line();
+        buffer += '}';
     }
 
-    template <class NodeTy>
-    string SerializeNode(const Node& node) {
-        string result;
+    /*Plain chunks are appended at once, only quotes, backslashes and control characters are escaped*/
+    void Writer::write_string(string_view str) {
+        static constexpr string_view hex_digits{ "0123456789abcdef" };
+
+        buffer += '\"';
+        for (size_t pos; (pos = scanner::FindEscapable(str)) < str.length(); str.remove_prefix(pos + 1)) {
+            buffer.append(str.data(), pos);
+            switch (const char ch{ str[pos] }) {
+            case '\"': buffer += "\\\""; break;
+            case '\\': buffer += "\\\\"; break;
+            case '\b': buffer += "\\b"; break;
+            case '\f': buffer += "\\f"; break;
+            case '\n': buffer += "\\n"; break;
+            case '\r': buffer += "\\r"; break;
+            case '\t': buffer += "\\t"; break;
+            default:
+                (buffer += "\\u00") += hex_digits[static_cast<unsigned char>(ch) >> 4];
+                buffer += hex_digits[static_cast<unsigned char>(ch) & 0xF];
+            }
+        }
+        buffer += str;
+        buffer += '\"';
+    }
+
+    void Writer::new_line() {
+        if (format == Format::PRETTY) {
+            buffer += '\n';
+        }
+    }
+
+    void Writer::flush_if_full() {
+        if (output && buffer.size() >= flush_threshold) {
+            flush();
+        }
+    }
+
+    void Writer::flush() {
+        if (output) {
+            output->write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+
+    size_t EstimateSize(const Node& node) {
+        size_t size{ 0 };
         visit(
-            [&result, &node](const auto& value) {
-                result = SerializeNode<decay_t<decltype(value)>>(node); //Without decay_t we call general version of SerializeNode and get stack overflow
+            [&size](const auto& value) {
+                size = EstimateSize(value);
             },
             node.GetBase()
-       );
+        );
+        return size;
+    }
+
+    size_t EstimateSize(bool_t) {
+        return 5;
+    }
+
+    size_t EstimateSize(const number_t& number) {
+        return number.IsIntegral() ? 
+            numeric_limits<uint64_t>::digits10 + 2 : numeric_limits<double>::max_digits10 + 8;      //Sign, point and exponent
+    }
+
+    size_t EstimateSize(const string_t& str) {
+        return str.size() + 2;
+    }
+
+    size_t EstimateSize(string_view_t str) {
+        return str.size() + 2;
+    }
+
+    size_t EstimateSize(const array_t& array_data) {
+        size_t size{ 4 };
+        for (const auto& node : array_data) {
+            size += EstimateSize(node) + 2;
+        }
+        return size;
+    }
+
+    size_t EstimateSize(const map_t& dict_data) {
+        size_t size{ 4 };
+        for (const auto& [key, node] : dict_data) {
+            size += key.size() + EstimateSize(node) + 6;
+        }
+        return size;
+    }
+
+    size_t EstimateSize(const verbatim_t& verbatim) {
+        return verbatim.text.size();
+    }
+
+    string Serialize(const Document& doc, Format format, optional<int> precision) {
+        string result;
+        Writer(result, format, precision).Write(doc.GetRoot());
         return result;
     }
 
-    string Serialize(const Document& doc) {
-        return SerializeNode<Node>(doc.GetRoot());
+    void Serialize(const Document& doc, ostream& output, Format format, optional<int> precision) {
+        Writer(output, format, precision).Write(doc.GetRoot());
     }
 }
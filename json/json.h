@@ -14,28 +14,87 @@
 #include <vector>
 #include <functional>
 #include <type_traits>
-
-#include <map>
+#include <optional>
+#include <memory>
+#include <memory_resource>
+#include <initializer_list>
+#include <stdexcept>
+#include <iterator>
+#include <utility>
+#include <tuple>
 
 namespace Json {
     class Node;
 
-    /*Types of JSON Nodes*/
+    /*Types of JSON Nodes (allocator-aware: loaded documents keep them in the arena)*/
     using bool_t = bool;
     using number_t = Number;
-    using string_t = std::string;
-    using array_t = std::vector<Node>;   
+    using string_t = std::pmr::string;
+    using string_view_t = std::string_view;     //Unescaped string borrowed from the input (see LoadInPlace)
+    using array_t = std::pmr::vector<Node>;   
+
+    /*Pre-serialized JSON value (e.g. a cached answer): it is written as is in any format*/
+    struct Verbatim {
+        string_t text;
+    };
+    using verbatim_t = Verbatim;
+
+    /*Flat JSON object: key-value pairs in insertion order (serialization order too).
+    Objects are small, so a linear scan over contiguous keys is faster than a tree walk*/
+    class Object {
+    public:
+        using key_type = string_t;
+        using mapped_type = Node;
+        using value_type = std::pair<string_t, Node>;
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+    private:
+        using Storage = std::pmr::vector<value_type>;
+    public:
+        using iterator = Storage::iterator;
+        using const_iterator = Storage::const_iterator;
+    public:
+        Object() = default;
+        explicit Object(const allocator_type& allocator);
+        Object(std::initializer_list<value_type> items, const allocator_type& allocator = {});
 
-    /*We can't use unordered map because in GCC unordered map template instantiation requires complete type*/
-    using map_t = std::map<std::string, Node>;  
+        /*Heterogeneous lookup (no temporary strings)*/
+        const_iterator find(std::string_view key) const noexcept;
+        iterator find(std::string_view key) noexcept;
+        bool contains(std::string_view key) const noexcept;
+        const Node& at(std::string_view key) const;
+
+        /*The existing value isn't replaced (as in std::map)*/
+        std::pair<iterator, bool> insert(value_type item);
+        template <class Key, class... Types>
+        std::pair<iterator, bool> emplace(Key&& key, Types&&... args);
+
+        void reserve(size_t capacity);
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+        iterator begin() noexcept;
+        iterator end() noexcept;
+    private:
+        Storage items;
+    };
+
+    using map_t = Object;
+
+    /*Monotonic memory for the whole JSON Tree*/
+    using Arena = std::pmr::monotonic_buffer_resource;
 
     /*JSON Node*/
     class Node : std::variant
         <bool_t,
         number_t,
         string_t,
+        string_view_t,
         array_t,
-        map_t> {
+        map_t,
+        verbatim_t> {
+        friend class Builder;
     public:
         /*Overloaded c-tors*/
         using variant::variant;
@@ -51,7 +110,10 @@ namespace Json {
         const auto& AsMap() const {
             return std::get<map_t>(*this);
         }
-        const auto& AsString() const {
+        std::string_view AsString() const {
+            if (const auto* view = std::get_if<string_view_t>(std::addressof(GetBase()))) {
+                return *view;
+            }
             return std::get<string_t>(*this);
         }
         const auto& AsNumber() const {
@@ -62,13 +124,108 @@ namespace Json {
         }
     };
 
+    inline Object::Object(const allocator_type& allocator)
+        : items(allocator) {
+    }
+
+    inline Object::Object(std::initializer_list<value_type> items_, const allocator_type& allocator)
+        : items(allocator) {
+        items.reserve(items_.size());
+        for (const auto& item : items_) {
+            insert(item);
+        }
+    }
+
+    inline Object::const_iterator Object::find(std::string_view key) const noexcept {
+        auto it{ items.begin() };
+        for (; it != items.end() && it->first != key; ++it);
+        return it;
+    }
+
+    inline Object::iterator Object::find(std::string_view key) noexcept {
+        auto it{ items.begin() };
+        for (; it != items.end() && it->first != key; ++it);
+        return it;
+    }
+
+    inline bool Object::contains(std::string_view key) const noexcept {
+        return find(key) != items.end();
+    }
+
+    inline const Node& Object::at(std::string_view key) const {
+        const auto it{ find(key) };
+        if (it == items.end()) {
+            throw std::out_of_range("Json::Object: key not found");
+        }
+        return it->second;
+    }
+
+    inline std::pair<Object::iterator, bool> Object::insert(value_type item) {
+        return emplace(std::move(item.first), std::move(item.second));
+    }
+
+    template <class Key, class... Types>
+    std::pair<Object::iterator, bool> Object::emplace(Key&& key, Types&&... args) {
+        if (auto it = find(key); it != items.end()) {
+            return { it, false };
+        }
+        items.emplace_back(
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<Key>(key)),
+            std::forward_as_tuple(std::forward<Types>(args)...)
+        );
+        return { std::prev(items.end()), true };
+    }
+
+    inline void Object::reserve(size_t capacity) {
+        items.reserve(capacity);
+    }
+
+    inline size_t Object::size() const noexcept {
+        return items.size();
+    }
+
+    inline bool Object::empty() const noexcept {
+        return items.empty();
+    }
+
+    inline Object::const_iterator Object::begin() const noexcept {
+        return items.begin();
+    }
+
+    inline Object::const_iterator Object::end() const noexcept {
+        return items.end();
+    }
+
+    inline Object::iterator Object::begin() noexcept {
+        return items.begin();
+    }
+
+    inline Object::iterator Object::end() noexcept {
+        return items.end();
+    }
+
     /*This class encapculates unmodifiable JSON Tree*/
     class Document {
     public:
         explicit Document(Node root);
+
+        /*The tree must be allocated from the arena: it is released at once without destructor calls*/
+        Document(std::unique_ptr<Arena> arena_, Node root_);
+
+        /*Parts of the tree may be allocated from the additional arenas (e.g. by parallel parsing)*/
+        Document(std::unique_ptr<Arena> arena_, std::vector<std::unique_ptr<Arena>> chunk_arenas_, Node root_);
+
         const Node& GetRoot() const;
     private:
-        Node root;
+        struct NodeDeleter {
+            bool owner{ true };
+            void operator()(Node* node) const noexcept;
+        };
+    private:
+        std::unique_ptr<Arena> arena;                       //Must be destroyed after the root
+        std::vector<std::unique_ptr<Arena>> chunk_arenas;
+        std::unique_ptr<Node, NodeDeleter> root;
     };
 
     /*spaces, comma and colons are service symbols*/
@@ -77,9 +234,118 @@ namespace Json {
     /*Reads lines from the istream until it encounters an empty line*/
     std::string Read(std::istream& input);
 
+    enum class Parsing {
+        SEQUENTIAL,
+        PARALLEL    //Large top-level arrays are split into chunks of elements parsed on worker threads
+    };
+
     /*Creates unmodifiable JSON Tree from string (string_view)*/
-    Document Load(std::string_view input);
+    Document Load(std::string_view input, Parsing parsing = Parsing::SEQUENTIAL);
+
+    /*Same, but string values without escape sequences are views into the input (no copies).
+    The input (e.g. Json::Source) must outlive the document*/
+    Document LoadInPlace(std::string_view input, Parsing parsing = Parsing::SEQUENTIAL);
+
+    /*Event-driven (SAX) parsing: handler receives values without building a JSON Tree.
+    Strings and keys are views into the input; the ones with escape sequences are decoded
+    into a scratch buffer that is valid only until the next event*/
+    struct ISaxHandler {
+        virtual void OnObjectStart() = 0;
+        virtual void OnObjectEnd() = 0;
+        virtual void OnArrayStart() = 0;
+        virtual void OnArrayEnd() = 0;
+        virtual void OnKey(std::string_view key) = 0;
+        virtual void OnString(std::string_view value) = 0;
+        virtual void OnNumber(Number value) = 0;
+        virtual void OnBool(bool value) = 0;
+        virtual ~ISaxHandler() = default;
+    };
+
+    void Parse(std::string_view input, ISaxHandler& handler);
+
+    /*Assembles a JSON Node from SAX events (e.g. for the parts of a document that aren't streamed)*/
+    class Builder : public ISaxHandler {
+    public:
+        explicit Builder(std::pmr::memory_resource* resource_ = std::pmr::get_default_resource()) noexcept;
+
+        void OnObjectStart() override;
+        void OnObjectEnd() override;
+        void OnArrayStart() override;
+        void OnArrayEnd() override;
+        void OnKey(std::string_view key) override;
+        void OnString(std::string_view value) override;
+        void OnNumber(Number value) override;
+        void OnBool(bool value) override;
+
+        /*The root value has been closed*/
+        bool IsComplete() const noexcept;
+        Node Extract();
+    private:
+        void close_container();
+        void add_value(Node value);
+    private:
+        std::pmr::memory_resource* resource;
+        std::vector<Node> stack;
+        std::vector<string_t> keys;
+        std::optional<Node> root;
+    };
+
+    /*Serialization format*/
+    enum class Format {
+        PRETTY,     //Each element on a separate line
+        COMPACT     //No line breaks and spaces
+    };
+
+    /*Appends serialized JSON to one growable buffer (or to the stream through a fixed-size buffer).
+    Strings are escaped. Doubles are written in the shortest round-trip form or with a fixed number of fractional digits*/
+    class Writer {
+    public:
+        Writer(std::string& buffer_, Format format_ = Format::PRETTY, std::optional<int> precision_ = std::nullopt);
+        Writer(std::ostream& output_, Format format_ = Format::PRETTY, std::optional<int> precision_ = std::nullopt);
+
+        void Write(const Node& node);
+        void Write(const array_t& array);
+        void Write(const map_t& dict);
+    private:
+        void write_node(const Node& node);
+        void write_value(bool_t value);
+        void write_value(const number_t& number);
+        void write_value(const string_t& str);
+        void write_value(string_view_t str);
+        void write_value(const array_t& array);
+        void write_value(const map_t& dict);
+        void write_value(const verbatim_t& verbatim);
+        void write_array(const array_t& array_data);
+        void write_dict(const map_t& dict_data);
+        void write_string(std::string_view str);
+
+        void new_line();
+        void flush_if_full();
+        void flush();
+    private:
+        static constexpr size_t flush_threshold{ 1 << 16 };
+
+        std::string own_buffer;
+        std::string& buffer;
+        std::ostream* output{ nullptr };
+        Format format;
+        std::optional<int> precision;
+    };
+
+    /*Estimate of the serialized size (used to reserve the buffer). Escape sequences and pretty
+    indentation aren't counted: the buffer just grows past the estimate for such documents*/
+    size_t EstimateSize(const Node& node);
+    size_t EstimateSize(bool_t value);
+    size_t EstimateSize(const number_t& number);
+    size_t EstimateSize(const string_t& str);
+    size_t EstimateSize(string_view_t str);
+    size_t EstimateSize(const array_t& array_data);
+    size_t EstimateSize(const map_t& dict_data);
+    size_t EstimateSize(const verbatim_t& verbatim);
 
     /*Serializes unmodifiable JSON Tree to string*/
-    std::string Serialize(const Document& doc);
+    std::string Serialize(const Document& doc, Format format = Format::PRETTY, std::optional<int> precision = std::nullopt);
+
+    /*Serializes unmodifiable JSON Tree directly to the stream*/
+    void Serialize(const Document& doc, std::ostream& output, Format format = Format::PRETTY, std::optional<int> precision = std::nullopt);
 }
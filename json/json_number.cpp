@@ -1,43 +1,60 @@
 #include "json_number.h"
 
+/*For fabs*/
+#include <cmath>
+#include <type_traits>
+
 namespace Json {
-    Number::Number(const NumberHolder& number_) noexcept
-        : number{ number_ }
+    Number::Number(uint64_t num) noexcept
+        : value{ num }
     {
     }
-    Number::Number(uint64_t num) noexcept {
-        number.whole = num;
-    }
-    Number::Number(double num) noexcept {
-        number.whole = static_cast<uint64_t>(num);
-        number.fractional_length = NumberHolder::precision;
-        number.fractional = static_cast<uint64_t>((num - number.whole) * pow(static_cast<uint64_t>(10), NumberHolder::precision));
+    Number::Number(int64_t num) noexcept
+        : value{ num }
+    {
     }
-    Number::operator uint64_t() const noexcept { 
-        return number.whole; 
+    Number::Number(double num) noexcept
+        : value{ num }
+    {
     }
-    Number::operator double() const noexcept {
-        double result{ static_cast<double>(number.whole) };
-        if (number.fractional_length) {
-            result += static_cast<double>(number.fractional) / pow(10, static_cast<double>(number.fractional_length));
-        }
-        return number.negative ?
-            -result : result;
+
+    bool Number::IsIntegral() const noexcept {
+        return !std::holds_alternative<double>(value);
     }
 
-    uint64_t Number::GetWhole() const noexcept {
-        return number.whole;
+    bool Number::IsNegative() const noexcept {
+        return Visit([](auto num) {
+            if constexpr (std::is_signed_v<decltype(num)>) {
+                return num < 0;
+            }
+            else {
+                return false;
+            }
+            });
     }
 
-    uint64_t Number::GetFractional() const noexcept {
-        return number.fractional;
+    uint64_t Number::GetWhole() const noexcept {
+        if (const auto* num = std::get_if<int64_t>(&value)) {
+            return *num < 0 ? 0 - static_cast<uint64_t>(*num) : static_cast<uint64_t>(*num);
+        }
+        if (const auto* num = std::get_if<double>(&value)) {
+            return static_cast<uint64_t>(std::fabs(*num));
+        }
+        return std::get<uint64_t>(value);
     }
 
-    uint64_t Number::GetFractionalLength() const noexcept {
-        return number.fractional_length;
+    Number::operator uint64_t() const noexcept {
+        if (const auto* num = std::get_if<double>(&value)) {
+            return *num < 0 ? static_cast<uint64_t>(static_cast<int64_t>(*num)) : static_cast<uint64_t>(*num);
+        }
+        return Visit([](auto num) {
+            return static_cast<uint64_t>(num);
+            });
     }
 
-    bool Number::IsNegative() const noexcept {
-        return number.negative;
+    Number::operator double() const noexcept {
+        return Visit([](auto num) {
+            return static_cast<double>(num);
+            });
     }
 }
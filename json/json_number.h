@@ -2,38 +2,33 @@
 /*Standart headers*/
 #include <cstdint>
 #include <limits>
-
-/*For pow(x, y)*/
-#include <cmath>
+#include <variant>
+#include <utility>
 
 namespace Json {
-	struct NumberHolder {
-        bool negative { false };
-        uint64_t whole { 0 },
-            fractional { 0 },
-            fractional_length { 0 };
-        static constexpr uint64_t precision{ std::numeric_limits<uint64_t>::digits10 };
-	};
-
+	/*Integers are stored exactly, other numbers are converted to double once (at parse time)*/
 	class Number {
     public:
         Number() = default;
-        Number(const NumberHolder& number_) noexcept;
         explicit Number(uint64_t num) noexcept;
-        explicit  Number(double num) noexcept;
+        explicit Number(int64_t num) noexcept;
+        explicit Number(double num) noexcept;
     public:
-        uint64_t GetWhole() const noexcept;
-        uint64_t GetFractional() const noexcept;
-        uint64_t GetFractionalLength() const noexcept;
+        bool IsIntegral() const noexcept;
         bool IsNegative() const noexcept;
-    public:
-        static constexpr uint64_t GetMaxPrecision() noexcept {
-            return NumberHolder::precision;
-        }
+
+        /*Absolute value of the integral part*/
+        uint64_t GetWhole() const noexcept;
     public:
         operator uint64_t() const noexcept;
         operator double() const noexcept;
+    public:
+        /*Calls visitor with the stored uint64_t, int64_t or double*/
+        template <class Visitor>
+        decltype(auto) Visit(Visitor&& visitor) const {
+            return std::visit(std::forward<Visitor>(visitor), value);
+        }
     private:
-        NumberHolder number;
+        std::variant<uint64_t, int64_t, double> value{ uint64_t{ 0 } };
 	};
 }
@@ -0,0 +1,228 @@
+#pragma once
+/*Standart headers*/
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*The widest instruction set allowed by the compiler flags is selected (e.g. -mavx2 or -march=native)*/
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_SCANNER_AVX2
+#define JSON_SCANNER_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_SCANNER_SSE2
+#endif
+
+/*Vectorized classification of JSON characters (16 or 32 bytes per step, scalar tail)*/
+namespace Json::scanner {
+    namespace detail {
+        /*Character classes. Each class provides a scalar predicate and (if available) SIMD masks*/
+        struct Service {
+            static constexpr bool Test(char ch) noexcept {
+                /*Same set as isspace() in "C" locale plus comma and colon*/
+                return ch == ' ' || ch == ',' || ch == ':' || static_cast<unsigned char>(ch - '\t') <= '\r' - '\t';
+            }
+#ifdef JSON_SCANNER_SSE2
+            static uint32_t Mask(__m128i block) noexcept {
+                const __m128i shifted{ _mm_sub_epi8(block, _mm_set1_epi8('\t')) },
+                    control{ _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted) },
+                    separators{ _mm_or_si128(
+                        _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                        _mm_or_si128(
+                            _mm_cmpeq_epi8(block, _mm_set1_epi8(',')),
+                            _mm_cmpeq_epi8(block, _mm_set1_epi8(':'))
+                        )
+                    ) };
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(control, separators)));
+            }
+#endif
+#ifdef JSON_SCANNER_AVX2
+            static uint32_t Mask(__m256i block) noexcept {
+                const __m256i shifted{ _mm256_sub_epi8(block, _mm256_set1_epi8('\t')) },
+                    control{ _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted) },
+                    separators{ _mm256_or_si256(
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                        _mm256_or_si256(
+                            _mm256_cmpeq_epi8(block, _mm256_set1_epi8(',')),
+                            _mm256_cmpeq_epi8(block, _mm256_set1_epi8(':'))
+                        )
+                    ) };
+                return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(control, separators)));
+            }
+#endif
+        };
+
+        struct Quote {
+            static constexpr bool Test(char ch) noexcept {
+                return ch == '\"';
+            }
+#ifdef JSON_SCANNER_SSE2
+            static uint32_t Mask(__m128i block) noexcept {
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\"'))));
+            }
+#endif
+#ifdef JSON_SCANNER_AVX2
+            static uint32_t Mask(__m256i block) noexcept {
+                return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\"'))));
+            }
+#endif
+        };
+
+        struct QuoteOrEscape {
+            static constexpr bool Test(char ch) noexcept {
+                return ch == '\"' || ch == '\\';
+            }
+#ifdef JSON_SCANNER_SSE2
+            static uint32_t Mask(__m128i block) noexcept {
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(
+                    _mm_cmpeq_epi8(block, _mm_set1_epi8('\"')),
+                    _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))
+                )));
+            }
+#endif
+#ifdef JSON_SCANNER_AVX2
+            static uint32_t Mask(__m256i block) noexcept {
+                return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\"')),
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'))
+                )));
+            }
+#endif
+        };
+
+        /*Characters that must be escaped in JSON strings*/
+        struct Escapable {
+            static constexpr bool Test(char ch) noexcept {
+                return QuoteOrEscape::Test(ch) || static_cast<unsigned char>(ch) < 0x20;
+            }
+#ifdef JSON_SCANNER_SSE2
+            static uint32_t Mask(__m128i block) noexcept {
+                const __m128i control{ _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1F)), block) };
+                return QuoteOrEscape::Mask(block) | static_cast<uint32_t>(_mm_movemask_epi8(control));
+            }
+#endif
+#ifdef JSON_SCANNER_AVX2
+            static uint32_t Mask(__m256i block) noexcept {
+                const __m256i control{ _mm256_cmpeq_epi8(_mm256_min_epu8(block, _mm256_set1_epi8(0x1F)), block) };
+                return QuoteOrEscape::Mask(block) | static_cast<uint32_t>(_mm256_movemask_epi8(control));
+            }
+#endif
+        };
+
+        /*Quotes and brackets: everything the structural pre-scan has to look at*/
+        struct Structural {
+            static constexpr bool Test(char ch) noexcept {
+                return ch == '\"' || ch == '[' || ch == ']' || ch == '{' || ch == '}';
+            }
+#ifdef JSON_SCANNER_SSE2
+            static uint32_t Mask(__m128i block) noexcept {
+                const __m128i brackets{ _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('[')), _mm_cmpeq_epi8(block, _mm_set1_epi8(']'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('{')), _mm_cmpeq_epi8(block, _mm_set1_epi8('}')))
+                ) };
+                return Quote::Mask(block) | static_cast<uint32_t>(_mm_movemask_epi8(brackets));
+            }
+#endif
+#ifdef JSON_SCANNER_AVX2
+            static uint32_t Mask(__m256i block) noexcept {
+                const __m256i brackets{ _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8(']'))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('}')))
+                ) };
+                return Quote::Mask(block) | static_cast<uint32_t>(_mm256_movemask_epi8(brackets));
+            }
+#endif
+        };
+
+        struct Digit {
+            static constexpr bool Test(char ch) noexcept {
+                return static_cast<unsigned char>(ch - '0') <= 9;
+            }
+#ifdef JSON_SCANNER_SSE2
+            static uint32_t Mask(__m128i block) noexcept {
+                const __m128i shifted{ _mm_sub_epi8(block, _mm_set1_epi8('0')) };
+                return static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted)
+                ));
+            }
+#endif
+#ifdef JSON_SCANNER_AVX2
+            static uint32_t Mask(__m256i block) noexcept {
+                const __m256i shifted{ _mm256_sub_epi8(block, _mm256_set1_epi8('0')) };
+                return static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(9)), shifted)
+                ));
+            }
+#endif
+        };
+
+        /*Returns the position of the first character for which Class::Test() != Expected (or str.length())*/
+        template <class Class, bool Expected>
+        size_t Scan(std::string_view str) noexcept {
+            const char* data{ str.data() };
+            const size_t length{ str.length() };
+            size_t pos{ 0 };
+#ifdef JSON_SCANNER_AVX2
+            for (; pos + 32 <= length; pos += 32) {
+                uint32_t mask{ Class::Mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos))) };
+                if constexpr (Expected) {
+                    mask = ~mask;
+                }
+                if (mask) {
+                    return pos + static_cast<size_t>(std::countr_zero(mask));
+                }
+            }
+#endif
+#ifdef JSON_SCANNER_SSE2
+            for (; pos + 16 <= length; pos += 16) {
+                uint32_t mask{ Class::Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos))) };
+                if constexpr (Expected) {
+                    mask = ~mask & 0xFFFF;
+                }
+                if (mask) {
+                    return pos + static_cast<size_t>(std::countr_zero(mask));
+                }
+            }
+#endif
+            for (; pos < length && Class::Test(data[pos]) == Expected; ++pos);     //Scalar tail (or fallback)
+            return pos;
+        }
+    }
+
+    /*Length of the prefix consisting of spaces, commas and colons*/
+    inline size_t SkipService(std::string_view str) noexcept {
+        return detail::Scan<detail::Service, true>(str);
+    }
+
+    /*Position of the first quote (or str.length() if there is none)*/
+    inline size_t FindQuote(std::string_view str) noexcept {
+        return detail::Scan<detail::Quote, false>(str);
+    }
+
+    /*Position of the first quote or backslash (or str.length() if there is none)*/
+    inline size_t FindQuoteOrEscape(std::string_view str) noexcept {
+        return detail::Scan<detail::QuoteOrEscape, false>(str);
+    }
+
+    /*Position of the first character that must be escaped on output (or str.length() if there is none)*/
+    inline size_t FindEscapable(std::string_view str) noexcept {
+        return detail::Scan<detail::Escapable, false>(str);
+    }
+
+    /*Position of the first quote or bracket (or str.length() if there is none)*/
+    inline size_t FindStructural(std::string_view str) noexcept {
+        return detail::Scan<detail::Structural, false>(str);
+    }
+
+    /*Length of the prefix consisting of decimal digits*/
+    inline size_t CountDigits(std::string_view str) noexcept {
+        return detail::Scan<detail::Digit, true>(str);
+    }
+
+    /*Scalar version of the service symbols check*/
+    inline constexpr bool IsService(char ch) noexcept {
+        return detail::Service::Test(ch);
+    }
+}
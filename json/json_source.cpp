@@ -0,0 +1,161 @@
+#include "json_source.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JSON_SOURCE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Json {
+#ifdef JSON_SOURCE_POSIX
+    namespace {
+        /*Closes the descriptor on scope exit*/
+        struct Descriptor {
+            int fd;
+            ~Descriptor() {
+                ::close(fd);
+            }
+        };
+
+        [[noreturn]] void ThrowSystemError(const char* what) {
+            throw system_error(errno, generic_category(), what);
+        }
+
+        /*Size of a regular file (0 for pipes and terminals)*/
+        size_t RegularFileSize(int fd) {
+            struct stat info {};
+            if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+                return 0;
+            }
+            return static_cast<size_t>(info.st_size);
+        }
+
+        /*Fills the buffer with read(2) calls until EOF, doubling the capacity when it runs out*/
+        void ReadAll(int fd, string& buffer) {
+            static constexpr size_t min_block{ 1 << 20 };
+            size_t size{ 0 };
+            buffer.resize(RegularFileSize(fd) + min_block);
+
+            while (true) {
+                if (size == buffer.size()) {
+                    buffer.resize(buffer.size() * 2);
+                }
+                const ssize_t count{ ::read(fd, buffer.data() + size, buffer.size() - size) };
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count < 0) {
+                    ThrowSystemError("Json::Source: read failed");
+                }
+                if (count == 0) {
+                    break;
+                }
+                size += static_cast<size_t>(count);
+            }
+            buffer.resize(size);
+        }
+    }
+
+    Source Source::MapFile(const string& path) {
+        const Descriptor file{ ::open(path.c_str(), O_RDONLY) };
+        if (file.fd < 0) {
+            ThrowSystemError("Json::Source: can't open the file");
+        }
+
+        Source source;
+        const size_t size{ RegularFileSize(file.fd) };
+        if (size == 0) {		//Nothing to map (empty file or not a regular file)
+            ReadAll(file.fd, source.buffer);
+            return source;
+        }
+
+        void* address{ ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd, 0) };
+        if (address == MAP_FAILED) {
+            ThrowSystemError("Json::Source: mmap failed");
+        }
+        ::madvise(address, size, MADV_SEQUENTIAL);
+        source.mapping = static_cast<const char*>(address);
+        source.mapping_size = size;
+        return source;
+    }
+
+    Source Source::ReadStandardInput() {
+        Source source;
+        ReadAll(STDIN_FILENO, source.buffer);
+        return source;
+    }
+
+    void Source::unmap() noexcept {
+        if (mapping) {
+            ::munmap(const_cast<char*>(mapping), mapping_size);
+        }
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+#else
+    Source Source::MapFile(const string& path) {
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file) {
+            throw system_error(make_error_code(errc::no_such_file_or_directory), "Json::Source: can't open the file");
+        }
+        Source source;
+        source.buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(source.buffer.data(), static_cast<streamsize>(source.buffer.size()));
+        return source;
+    }
+
+    Source Source::ReadStandardInput() {
+        static constexpr size_t block{ 1 << 20 };
+        Source source;
+        size_t size{ 0 };
+        while (true) {
+            source.buffer.resize(size + block);
+            const size_t count{ fread(source.buffer.data() + size, 1, block, stdin) };
+            size += count;
+            if (count < block) {
+                break;
+            }
+        }
+        source.buffer.resize(size);
+        return source;
+    }
+
+    void Source::unmap() noexcept {
+    }
+#endif
+
+    Source::Source(Source&& other) noexcept
+        : buffer{ move(other.buffer) },
+        mapping{ exchange(other.mapping, nullptr) },
+        mapping_size{ exchange(other.mapping_size, 0) } {
+    }
+
+    Source& Source::operator=(Source&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            buffer = move(other.buffer);
+            mapping = exchange(other.mapping, nullptr);
+            mapping_size = exchange(other.mapping_size, 0);
+        }
+        return *this;
+    }
+
+    Source::~Source() {
+        unmap();
+    }
+
+    string_view Source::View() const noexcept {
+        return mapping ? string_view(mapping, mapping_size) : string_view(buffer);
+    }
+}
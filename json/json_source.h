@@ -0,0 +1,33 @@
+#pragma once
+/*Standart headers*/
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Json {
+    /*Raw JSON text: a read-only memory-mapped file or one buffer filled with large reads.
+    Documents loaded in place keep views into it, so it must outlive them*/
+    class Source {
+    public:
+        /*Maps the whole file (falls back to a single read where mmap is unavailable)*/
+        static Source MapFile(const std::string& path);
+
+        /*Reads the standard input until EOF*/
+        static Source ReadStandardInput();
+
+        Source(Source&& other) noexcept;
+        Source& operator=(Source&& other) noexcept;
+        Source(const Source&) = delete;
+        Source& operator=(const Source&) = delete;
+        ~Source();
+
+        std::string_view View() const noexcept;
+    private:
+        Source() = default;
+        void unmap() noexcept;
+    private:
+        std::string buffer;
+        const char* mapping{ nullptr };
+        size_t mapping_size{ 0 };
+    };
+}
@@ -7,7 +7,7 @@
 #endif
 using namespace std;
 
-int main()
+int main(int argc, char* argv[])
 {
 #ifdef WINDOWS_DEBUG
     SetConsoleCP(1251);
@@ -17,38 +17,79 @@ int main()
         cin.tie(nullptr);
         ios_base::sync_with_stdio(false);
     }();
+    const Options options{ ParseOptions(argc, argv) };
     TransportCatalog tr_catalog;
 
-    string raw_json_doc{ Json::Read(cin) };
+    /*The input file is memory-mapped (standard input is read into one buffer).
+    The document and the catalog refer to it, so it lives until the end*/
+    const Json::Source source{ options.input ?
+        Json::Source::MapFile(*options.input) : Json::Source::ReadStandardInput()
+    };
+    const string_view raw_json_doc{ source.View() };
 
-    Json::Document doc{ Json::Load(
-       raw_json_doc
+#ifdef STREAMING
+    Json::Document doc{ request::IngestBaseRequests(     //base_requests go straight to the catalog
+       raw_json_doc,
+       tr_catalog
+    ) };
+    const auto& stat{ GetBranch(doc, "stat_requests").AsArray() };
+#else
+    Json::Document doc{ Json::LoadInPlace(
+       raw_json_doc,
+#ifdef MULTITHREADING
+       Json::Parsing::PARALLEL
+#else
+       Json::Parsing::SEQUENTIAL
+#endif
     ) };
 
     const auto& [base, stat] {SplitByCategories(doc)};
+#endif
 
-    request::Read::Storage result;
-
-    unique_ptr<request::IFactory> base_factory{ make_unique<request::ModifyRequestFactory>(request::Modify::Settings{ tr_catalog }) },
-        stat_factory{ make_unique<request::ReadRequestFactory>(request::Read::Settings{tr_catalog, result}) };
+    request::Read::Storage result(stat.size());       //A slot for each answer
+#ifdef COMPACT_OUTPUT
+    constexpr Json::Format output_format{ Json::Format::COMPACT };
+#else
+    constexpr Json::Format output_format{ Json::Format::PRETTY };
+#endif
+    request::AnswerCache answers(output_format);      //Bus and Stop answers are serialized once
 
-    auto base_update{ MakeHandlers(base_factory.get(), base) },
-        base_stat{ MakeHandlers(stat_factory.get(), stat) };
+    unique_ptr<request::IFactory> stat_factory{ make_unique<request::ReadRequestFactory>(request::Read::Settings{tr_catalog, result, &answers}) };
+#ifndef STREAMING
+    unique_ptr<request::IFactory> base_factory{ make_unique<request::ModifyRequestFactory>(request::Modify::Settings{ tr_catalog }) };
 
+    auto base_update{ MakeHandlers(base_factory.get(), base) };
     ProcessRequests(base_update);
-
-    tr_catalog.SetRoutingSettings(
-        ExtractRoadSettings(doc)
-    );
+#endif
 #ifdef RENDER
     tr_catalog.SetRenderSettings(
         ExtractRenderSettings(doc)
     );
 #endif
-    tr_catalog.Synchronize();
-
+    if (options.load_snapshot) {
+        tr_catalog.LoadSnapshot(*options.load_snapshot);        //base_requests of the input are dropped
+    }
+    else {
+        tr_catalog.SetRoutingSettings(
+            ExtractRoadSettings(doc)
+        );
+    }
+#ifdef MULTITHREADING
+    algo::execution::sync_wait(
+        AnswerRequests(stat_factory.get(), stat, tr_catalog, &answers)
+    );
+#else
+    auto base_stat{ MakeHandlers(stat_factory.get(), stat) };
+    if (!tr_catalog.IsSynchronized()) {
+        tr_catalog.Synchronize();
+    }
+    answers.Build(tr_catalog);
     ProcessRequests(base_stat);
-    cout << SerializeResult(result);
+#endif
+    if (options.save_snapshot) {
+        tr_catalog.SaveSnapshot(*options.save_snapshot);
+    }
+    SerializeResult(result, cout, output_format);
 
     return 0;
 }
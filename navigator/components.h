@@ -0,0 +1,147 @@
+#pragma once
+#include "frozen_graph.h"
+
+/*Standart headers*/
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+	/*Connectivity components of a directed graph.
+	Strongly connected components (Tarjan) are numbered in the reverse topological order of the condensation:
+	if a vertex reaches a vertex of another component, its component id is greater.
+	Weakly connected components separate the isolated parts of the graph*/
+	class Components {
+	public:
+		using ComponentId = uint32_t;
+
+		Components() = default;
+		Components(std::vector<ComponentId> strong_, std::vector<ComponentId> weak_) noexcept;
+
+		template <class Graph>
+		explicit Components(const Graph& graph);
+
+		template <class Graph>
+		static std::vector<ComponentId> FindStrong(const Graph& graph);
+
+		template <class Graph>
+		static std::vector<ComponentId> FindWeak(const Graph& graph);
+
+		/*True if there is no path for sure (O(1)). The vertices added after the search are unknown*/
+		bool IsUnreachable(VertexId from, VertexId to) const noexcept;
+	private:
+		static constexpr ComponentId unassigned{ std::numeric_limits<ComponentId>::max() };
+
+		std::vector<ComponentId> strong;
+		std::vector<ComponentId> weak;
+	};
+
+
+	inline Components::Components(std::vector<ComponentId> strong_, std::vector<ComponentId> weak_) noexcept
+		: strong{ std::move(strong_) }, weak{ std::move(weak_) } {
+	}
+
+	template <class Graph>
+	Components::Components(const Graph& graph)
+		: Components(FindStrong(graph), FindWeak(graph)) {
+	}
+
+	template <class Graph>
+	std::vector<Components::ComponentId> Components::FindStrong(const Graph& graph) {
+		using EdgeIt = decltype(graph.GetOutgoingEdges(0).begin());
+
+		/*Iterative Tarjan: the call stack keeps the vertex and its unvisited outgoing edges*/
+		const size_t vertex_count{ graph.GetVertexCount() };
+		std::vector<ComponentId> component(vertex_count, unassigned);
+		std::vector<uint32_t> order(vertex_count, unassigned), low_link(vertex_count);
+		std::vector<VertexId> visited;										//Vertices without a component yet
+		std::vector<std::tuple<VertexId, EdgeIt, EdgeIt>> call_stack;
+		uint32_t next_order{ 0 };
+		ComponentId next_component{ 0 };
+
+		auto visit{ [&](VertexId vertex) {
+			order[vertex] = low_link[vertex] = next_order++;
+			visited.push_back(vertex);
+			const auto outgoing_edges{ graph.GetOutgoingEdges(vertex) };
+			call_stack.emplace_back(vertex, outgoing_edges.begin(), outgoing_edges.end());
+		} };
+
+		for (VertexId root = 0; root < vertex_count; ++root) {
+			if (order[root] != unassigned) {
+				continue;
+			}
+			visit(root);
+			while (!call_stack.empty()) {
+				auto& [vertex, it, last] { call_stack.back() };
+				if (it != last) {
+					const VertexId to{ graph.GetTarget(*it) };
+					++it;
+					if (order[to] == unassigned) {
+						visit(to);											//The reference to the stack top is invalidated
+					}
+					else if (component[to] == unassigned) {				//The vertex is on the Tarjan stack
+						low_link[vertex] = std::min(low_link[vertex], order[to]);
+					}
+					continue;
+				}
+
+				const VertexId finished{ vertex };
+				call_stack.pop_back();
+				if (!call_stack.empty()) {
+					const VertexId parent{ std::get<0>(call_stack.back()) };
+					low_link[parent] = std::min(low_link[parent], low_link[finished]);
+				}
+				if (low_link[finished] == order[finished]) {
+					VertexId member;
+					do {
+						member = visited.back();
+						visited.pop_back();
+						component[member] = next_component;
+					} while (member != finished);
+					++next_component;
+				}
+			}
+		}
+		return component;
+	}
+
+	template <class Graph>
+	std::vector<Components::ComponentId> Components::FindWeak(const Graph& graph) {
+		/*Union-find over the edges*/
+		const size_t vertex_count{ graph.GetVertexCount() };
+		std::vector<ComponentId> parent(vertex_count);
+		std::iota(parent.begin(), parent.end(), ComponentId{ 0 });
+		auto find_root{ [&parent](ComponentId vertex) {
+			while (parent[vertex] != vertex) {
+				vertex = parent[vertex] = parent[parent[vertex]];			//Path halving
+			}
+			return vertex;
+		} };
+
+		for (VertexId from = 0; from < vertex_count; ++from) {
+			for (const EdgeId edge_id : graph.GetOutgoingEdges(from)) {
+				const ComponentId first_root{ find_root(static_cast<ComponentId>(from)) },
+					second_root{ find_root(static_cast<ComponentId>(graph.GetTarget(edge_id))) };
+				if (first_root != second_root) {
+					parent[std::max(first_root, second_root)] = std::min(first_root, second_root);
+				}
+			}
+		}
+		for (ComponentId vertex = 0; vertex < vertex_count; ++vertex) {
+			parent[vertex] = find_root(vertex);
+		}
+		return parent;
+	}
+
+	inline bool Components::IsUnreachable(VertexId from, VertexId to) const noexcept {
+		if (from >= strong.size() || to >= strong.size()) {
+			return false;
+		}
+		return weak[from] != weak[to] || strong[from] < strong[to];
+	}
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include "graph.h"
+
+/*Standart headers*/
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+	/*Read-only graph in CSR (compressed sparse row) form.
+	The outgoing edges of a vertex are a contiguous range of edge ids: the targets, the weights and the items
+	are parallel arrays indexed by edge id. Built once from DirectedWeightedGraph (the removed edges are dropped),
+	the edge ids follow the incidence lists of the builder*/
+	template <class EdgeWeight, class EdgeData>
+	class FrozenGraph {
+	public:
+		/*Type alias section*/
+		using Weight = EdgeWeight;
+		using Data = EdgeData;
+		using Builder = DirectedWeightedGraph<Weight, Data>;
+		using Edge = typename Builder::Edge;
+		using EdgeRange = std::ranges::iota_view<EdgeId, EdgeId>;
+
+		static constexpr uint32_t dropped{ std::numeric_limits<uint32_t>::max() };
+	public:
+		FrozenGraph() = default;
+		explicit FrozenGraph(const Builder& builder);
+
+		/*Adopts the arrays: offsets has vertex_count + 1 items, the rest have one item per edge*/
+		FrozenGraph(
+			std::vector<uint32_t> offsets_,
+			std::vector<uint32_t> targets_,
+			std::vector<Weight> weights_,
+			std::vector<Data> items_
+		);
+
+		size_t GetVertexCount() const noexcept;
+		size_t GetEdgeCount() const noexcept;
+
+		EdgeRange GetOutgoingEdges(VertexId from) const noexcept;
+		VertexId GetTarget(EdgeId edge_id) const noexcept;
+		Weight GetWeight(EdgeId edge_id) const noexcept;
+		const Data& GetData(EdgeId edge_id) const noexcept;
+
+		/*The first of the parallel edges (throws std::out_of_range if there is no edge)*/
+		EdgeId GetEdgeId(VertexId from, VertexId to) const;
+
+		/*Mutable copy for the graph updates (the edge ids are kept)*/
+		Builder Thaw() const;
+
+		/*Copy without the unused vertices: new_ids has the new id of each vertex (the order is kept) or dropped.
+		Only the vertices without edges can be dropped (throws std::invalid_argument)*/
+		FrozenGraph Compact(std::span<const uint32_t> new_ids) const;
+
+		/*Raw arrays (snapshot)*/
+		std::span<const uint32_t> GetOffsets() const noexcept;
+		std::span<const uint32_t> GetTargets() const noexcept;
+		std::span<const Weight> GetWeights() const noexcept;
+		std::span<const Data> GetItems() const noexcept;
+	private:
+		std::vector<uint32_t> offsets{ 0 };
+		std::vector<uint32_t> targets;
+		std::vector<Weight> weights;
+		std::vector<Data> items;
+	};
+
+
+	template <class Weight, class Data>
+	FrozenGraph<Weight, Data>::FrozenGraph(const Builder& builder) {
+		const size_t vertex_count{ builder.GetVertexCount() };
+		if (std::max(vertex_count, builder.GetEdgeCount()) > std::numeric_limits<uint32_t>::max()) {
+			throw std::length_error("The graph is too large for 32-bit ids");
+		}
+		offsets.reserve(vertex_count + 1);
+		targets.reserve(builder.GetEdgeCount());
+		weights.reserve(builder.GetEdgeCount());
+		items.reserve(builder.GetEdgeCount());
+		for (VertexId from = 0; from < vertex_count; ++from) {
+			for (const auto& [to, edge_id] : builder.GetIncidentRange(from)) {
+				const Edge& edge{ builder.GetEdge(edge_id) };
+				targets.push_back(static_cast<uint32_t>(to));
+				weights.push_back(edge.weight);
+				items.push_back(edge.item);
+			}
+			offsets.push_back(static_cast<uint32_t>(targets.size()));
+		}
+	}
+
+	template <class Weight, class Data>
+	FrozenGraph<Weight, Data>::FrozenGraph(
+		std::vector<uint32_t> offsets_,
+		std::vector<uint32_t> targets_,
+		std::vector<Weight> weights_,
+		std::vector<Data> items_
+	) : offsets{ std::move(offsets_) }, targets{ std::move(targets_) }, weights{ std::move(weights_) }, items{ std::move(items_) } {
+	}
+
+	template <class Weight, class Data>
+	size_t FrozenGraph<Weight, Data>::GetVertexCount() const noexcept {
+		return offsets.size() - 1;
+	}
+
+	template <class Weight, class Data>
+	size_t FrozenGraph<Weight, Data>::GetEdgeCount() const noexcept {
+		return targets.size();
+	}
+
+	template <class Weight, class Data>
+	typename FrozenGraph<Weight, Data>::EdgeRange FrozenGraph<Weight, Data>::GetOutgoingEdges(VertexId from) const noexcept {
+		return EdgeRange(EdgeId{ offsets[from] }, EdgeId{ offsets[from + 1] });
+	}
+
+	template <class Weight, class Data>
+	VertexId FrozenGraph<Weight, Data>::GetTarget(EdgeId edge_id) const noexcept {
+		return targets[edge_id];
+	}
+
+	template <class Weight, class Data>
+	Weight FrozenGraph<Weight, Data>::GetWeight(EdgeId edge_id) const noexcept {
+		return weights[edge_id];
+	}
+
+	template <class Weight, class Data>
+	const Data& FrozenGraph<Weight, Data>::GetData(EdgeId edge_id) const noexcept {
+		return items[edge_id];
+	}
+
+	template <class Weight, class Data>
+	EdgeId FrozenGraph<Weight, Data>::GetEdgeId(VertexId from, VertexId to) const {
+		const auto first{ targets.begin() + offsets[from] },
+			last{ targets.begin() + offsets[from + 1] };
+		const auto it{ std::find(first, last, static_cast<uint32_t>(to)) };
+		if (it == last) {
+			throw std::out_of_range("There is no edge between the vertices");
+		}
+		return static_cast<EdgeId>(it - targets.begin());
+	}
+
+	template <class Weight, class Data>
+	typename FrozenGraph<Weight, Data>::Builder FrozenGraph<Weight, Data>::Thaw() const {
+		std::vector<Edge> edges;
+		std::vector<typename Builder::IncidenceList> incidence_lists(GetVertexCount());
+		edges.reserve(GetEdgeCount());
+		for (VertexId from = 0; from < GetVertexCount(); ++from) {
+			incidence_lists[from].reserve(offsets[from + 1] - offsets[from]);
+			for (const EdgeId edge_id : GetOutgoingEdges(from)) {
+				edges.push_back(Edge{ from, targets[edge_id], weights[edge_id], items[edge_id] });
+				incidence_lists[from].emplace_back(targets[edge_id], edge_id);
+			}
+		}
+		return Builder(std::move(edges), std::move(incidence_lists));
+	}
+
+	template <class Weight, class Data>
+	FrozenGraph<Weight, Data> FrozenGraph<Weight, Data>::Compact(std::span<const uint32_t> new_ids) const {
+		FrozenGraph compacted;
+		compacted.targets.reserve(GetEdgeCount());
+		compacted.weights.reserve(GetEdgeCount());
+		compacted.items.reserve(GetEdgeCount());
+		for (VertexId from = 0; from < GetVertexCount(); ++from) {
+			if (new_ids[from] == dropped) {
+				if (offsets[from] != offsets[from + 1]) {
+					throw std::invalid_argument("Only isolated vertices can be dropped");
+				}
+				continue;
+			}
+			for (const EdgeId edge_id : GetOutgoingEdges(from)) {
+				if (new_ids[targets[edge_id]] == dropped) {
+					throw std::invalid_argument("Only isolated vertices can be dropped");
+				}
+				compacted.targets.push_back(new_ids[targets[edge_id]]);
+				compacted.weights.push_back(weights[edge_id]);
+				compacted.items.push_back(items[edge_id]);
+			}
+			compacted.offsets.push_back(static_cast<uint32_t>(compacted.targets.size()));
+		}
+		return compacted;
+	}
+
+	template <class Weight, class Data>
+	std::span<const uint32_t> FrozenGraph<Weight, Data>::GetOffsets() const noexcept {
+		return offsets;
+	}
+
+	template <class Weight, class Data>
+	std::span<const uint32_t> FrozenGraph<Weight, Data>::GetTargets() const noexcept {
+		return targets;
+	}
+
+	template <class Weight, class Data>
+	std::span<const Weight> FrozenGraph<Weight, Data>::GetWeights() const noexcept {
+		return weights;
+	}
+
+	template <class Weight, class Data>
+	std::span<const Data> FrozenGraph<Weight, Data>::GetItems() const noexcept {
+		return items;
+	}
+}
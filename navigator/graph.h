@@ -2,11 +2,13 @@
 #include "routing.h"
 #include "range.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 #include <tuple>
 #include <optional>
 #include <unordered_map>
+#include <utility>
 
 namespace Graph {
 
@@ -36,10 +38,18 @@ namespace Graph {
     public:
         DirectedWeightedGraph(size_t vertex_count);
 
+        /*Adopts the edges and the incidence lists (the removed edges are only in the edge list)*/
+        DirectedWeightedGraph(std::vector<Edge> edges_, std::vector<IncidenceList> incidence_lists);
+
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
 
         EdgeId AddEdge(const Edge& edge);
+        VertexId AddVertex();
+
+        /*The edge is detached from its vertices, GetEdge() still returns it*/
+        void RemoveEdge(EdgeId edge_id);
+
         bool HasEdge(VertexId from, VertexId to) const;
         EdgeId GetEdgeId(VertexId from, VertexId to) const;  
         const Edge& GetEdge(EdgeId edge_id) const;
@@ -54,6 +64,22 @@ namespace Graph {
     template <class Weight, class EdgeData>
     DirectedWeightedGraph<Weight, EdgeData>::DirectedWeightedGraph(size_t vertex_count) : incidence(vertex_count) {}
 
+    template <class Weight, class EdgeData>
+    DirectedWeightedGraph<Weight, EdgeData>::DirectedWeightedGraph(
+        std::vector<Edge> edges_,
+        std::vector<IncidenceList> incidence_lists
+    ) : edges{ std::move(edges_) } {
+        incidence.reserve(incidence_lists.size());
+        for (auto& incident_list : incidence_lists) {
+            IncidenceMap incident_map;
+            incident_map.reserve(incident_list.size());
+            for (const auto& [to, edge_id] : incident_list) {
+                incident_map.insert({ to, edge_id });                   //The first of the parallel edges, like AddEdge
+            }
+            incidence.emplace_back(std::move(incident_list), std::move(incident_map));
+        }
+    }
+
     template <class Weight, class EdgeData>
     EdgeId DirectedWeightedGraph<Weight, EdgeData>::AddEdge(const Edge& edge) {
         edges.push_back(edge);
@@ -64,6 +90,34 @@ namespace Graph {
         return id;
     }
 
+    template <class Weight, class EdgeData>
+    VertexId DirectedWeightedGraph<Weight, EdgeData>::AddVertex() {
+        incidence.emplace_back();
+        return incidence.size() - 1;
+    }
+
+    template <class Weight, class EdgeData>
+    void DirectedWeightedGraph<Weight, EdgeData>::RemoveEdge(EdgeId edge_id) {
+        const Edge& edge{ edges[edge_id] };
+        auto& [incident_list, incident_map] { incidence[edge.from] };
+        incident_list.erase(
+            std::find(incident_list.begin(), incident_list.end(), std::pair{ edge.to, edge_id })
+        );
+
+        /*Another edge between the same vertices takes the place in the map*/
+        if (auto it = incident_map.find(edge.to); it != incident_map.end() && it->second == edge_id) {
+            auto parallel_it{ std::find_if(incident_list.begin(), incident_list.end(), [&edge](const auto& item) {
+                return item.first == edge.to;
+                }) };
+            if (parallel_it != incident_list.end()) {
+                it->second = parallel_it->second;
+            }
+            else {
+                incident_map.erase(it);
+            }
+        }
+    }
+
     template <class Weight, class EdgeData>
     size_t DirectedWeightedGraph<Weight, EdgeData>::GetVertexCount() const {
         return incidence.size();
@@ -0,0 +1,135 @@
+#pragma once
+
+/*Standart headers*/
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+	/*Indexed d-ary min-heap of the items 0..n-1: an item is in the heap at most once and its key can be decreased.
+	The heap is a flat array of (key, item) pairs, the positions of the items are a flat array too.
+	Equal keys are ordered by the item, like std::set<std::pair<Key, Item>>*/
+	template <class Key, size_t Arity = 4>
+	class IndexedHeap {
+		static_assert(Arity >= 2);
+	public:
+		using Item = size_t;
+		using Entry = std::pair<Key, Item>;
+
+		explicit IndexedHeap(size_t item_count = 0);
+
+		/*Empties the heap for the items 0..item_count-1 (the storage is reused)*/
+		void Reset(size_t item_count);
+
+		bool Empty() const noexcept;
+		size_t Size() const noexcept;
+
+		/*Inserts the item or decreases its key (a greater key is ignored)*/
+		void Push(Item item, Key key);
+
+		Entry Pop();
+	private:
+		static constexpr size_t absent{ std::numeric_limits<size_t>::max() };
+
+		void sift_up(size_t pos);
+		void sift_down(size_t pos);
+		void place(size_t pos, Entry entry) noexcept;
+	private:
+		std::vector<Entry> heap;
+		std::vector<size_t> positions;
+	};
+
+
+	template <class Key, size_t Arity>
+	IndexedHeap<Key, Arity>::IndexedHeap(size_t item_count) : positions(item_count, absent) {}
+
+	template <class Key, size_t Arity>
+	void IndexedHeap<Key, Arity>::Reset(size_t item_count) {
+		heap.clear();
+		positions.assign(item_count, absent);
+	}
+
+	template <class Key, size_t Arity>
+	bool IndexedHeap<Key, Arity>::Empty() const noexcept {
+		return heap.empty();
+	}
+
+	template <class Key, size_t Arity>
+	size_t IndexedHeap<Key, Arity>::Size() const noexcept {
+		return heap.size();
+	}
+
+	template <class Key, size_t Arity>
+	void IndexedHeap<Key, Arity>::Push(Item item, Key key) {
+		const size_t pos{ positions[item] };
+		if (pos == absent) {
+			heap.emplace_back(key, item);
+			positions[item] = heap.size() - 1;
+			sift_up(heap.size() - 1);
+		}
+		else if (key < heap[pos].first) {
+			heap[pos].first = key;
+			sift_up(pos);
+		}
+	}
+
+	template <class Key, size_t Arity>
+	typename IndexedHeap<Key, Arity>::Entry IndexedHeap<Key, Arity>::Pop() {
+		const Entry top{ heap.front() };
+		positions[top.second] = absent;
+		const Entry last{ heap.back() };
+		heap.pop_back();
+		if (!heap.empty()) {
+			place(0, last);
+			sift_down(0);
+		}
+		return top;
+	}
+
+	template <class Key, size_t Arity>
+	void IndexedHeap<Key, Arity>::sift_up(size_t pos) {
+		const Entry entry{ heap[pos] };
+		while (pos != 0) {
+			const size_t parent{ (pos - 1) / Arity };
+			if (!(entry < heap[parent])) {
+				break;
+			}
+			place(pos, heap[parent]);
+			pos = parent;
+		}
+		place(pos, entry);
+	}
+
+	template <class Key, size_t Arity>
+	void IndexedHeap<Key, Arity>::sift_down(size_t pos) {
+		const Entry entry{ heap[pos] };
+		while (true) {
+			const size_t first_child{ pos * Arity + 1 };
+			if (first_child >= heap.size()) {
+				break;
+			}
+			size_t min_child{ first_child };
+			const size_t last_child{ std::min(first_child + Arity, heap.size()) };
+			for (size_t child = first_child + 1; child < last_child; ++child) {
+				if (heap[child] < heap[min_child]) {
+					min_child = child;
+				}
+			}
+			if (!(heap[min_child] < entry)) {
+				break;
+			}
+			place(pos, heap[min_child]);
+			pos = min_child;
+		}
+		place(pos, entry);
+	}
+
+	template <class Key, size_t Arity>
+	void IndexedHeap<Key, Arity>::place(size_t pos, Entry entry) noexcept {
+		positions[entry.second] = pos;
+		heap[pos] = std::move(entry);
+	}
+}
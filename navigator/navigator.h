@@ -1,5 +1,6 @@
 #pragma once
-#include "graph.h"
+#include "frozen_graph.h"
+#include "indexed_heap.h"
 
 /*Standart headers*/
 #include <set>
@@ -24,30 +25,46 @@ namespace Graph {
 		using Path = std::vector<VertexId>;
 		using Route = std::vector<EdgeId>;
 		using ParentsList = std::vector<std::optional<VertexId>>;
+		using DistanceInfo = std::vector<std::optional<Weight>>;
+		using Edge = typename Graph::Edge;
+
+		/*Shortest paths from one vertex (the distances are kept to check graph updates)*/
+		struct SearchTree {
+			ParentsList parents;
+			DistanceInfo distances;
+		};
 		
 		/*Type alias section #2 - single/multithread versions*/
 #ifdef MULTITHREADING
-		using ParentListCacheData = std::pair<std::optional<ParentsList>, std::mutex>;	
+		using ParentListCacheData = std::pair<std::optional<SearchTree>, std::mutex>;	
 #else
-		using ParentListCacheData = ParentsList;
+		using ParentListCacheData = SearchTree;
 #endif
 		using ParentListCache = std::unordered_map<VertexId, ParentListCacheData>;
 
 	private:
 		/*Type alias section #3 - navigator internal data*/
-		using DistanceInfo = std::vector<std::optional<Weight>>;
 		using DijkstraPair = std::pair<Weight, VertexId>;
-		using SearchHeap = std::set<DijkstraPair>;
+		using SearchHeap = std::set<DijkstraPair>;							//Sparse: the vertices added by an update
+		using DijkstraHeap = IndexedHeap<Weight>;							//Keyed by the tentative distance
 	public:
 		Navigator(const Graph& graph_) noexcept;
 
 		std::optional<Route> BuildRoute(VertexId from, VertexId to) const;
+
+		/*Must be called after the graph update (not concurrently with BuildRoute).
+		The cached trees that used a removed edge or get a shorter path through the added edges are dropped,
+		the rest are extended to the vertices added to the graph*/
+		void OnGraphUpdate(const std::vector<Edge>& removed_edges, const std::vector<Edge>& added_edges);
 	private:
 		/*Get parent list from cache*/
 		const ParentsList& get_parent_vertex_list(VertexId from) const;
 
 		/*Dijkstra algorithm*/
-		ParentsList relax_routes(VertexId from) const;
+		SearchTree relax_routes(VertexId from) const;
+
+		/*Graph update: returns false if the tree must be dropped*/
+		bool update_search_tree(SearchTree* tree, const std::vector<Edge>& removed_edges, const std::vector<Edge>& added_edges) const;
 
 		/*Making route (sequence of edges) from vector of route vertices*/
 		Route make_route(const Path& path) const;
@@ -62,7 +79,6 @@ namespace Graph {
 	private:
 		/*Data*/
 		const Graph& graph;
-		const size_t vertex_count;
 		
 		/*Cache*/
 		mutable ParentListCache parent_list_cache;
@@ -70,20 +86,14 @@ namespace Graph {
 #ifdef MULTITHREADING		
 		mutable std::mutex mtx;
 #else	/*Shared containers*/
-		mutable DistanceInfo distances;
-		mutable SearchHeap search_heap;
+		mutable DijkstraHeap search_heap;
 #endif
 	};
 
 
 	template <typename Graph>
 	Navigator<Graph>::Navigator(const Graph& graph_) noexcept
-		: graph(graph_), 
-		vertex_count{graph_.GetVertexCount()} {
-
-#ifndef MULTITHREADING
-		distances.reserve(vertex_count);
-#endif
+		: graph(graph_) {
 	}
 
 	template <typename Weight>
@@ -117,7 +127,7 @@ namespace Graph {
 			parent_list_bucket.first = relax_routes(from);
 		}
 
-		return *parent_list_bucket.first;
+		return parent_list_bucket.first->parents;
 	}
 
 	template <typename Weight>
@@ -133,46 +143,122 @@ namespace Graph {
 		auto it{ parent_list_cache.find(from) };
 
 		if (it == parent_list_cache.end()) {
-			distances.assign(vertex_count, std::nullopt);	//Reset distances cache
 			it = parent_list_cache.insert({
 				from,
 				relax_routes(from)
 				}).first;
 		}
-		return it->second;
+		return it->second.parents;
 	}
 #endif
 
 	template <typename Weight>
-	typename Navigator<Weight>::ParentsList Navigator<Weight>::relax_routes(VertexId from) const {
+	typename Navigator<Weight>::SearchTree Navigator<Weight>::relax_routes(VertexId from) const {
+		const size_t vertex_count{ graph.GetVertexCount() };
 		ParentsList parents(vertex_count, std::nullopt);
+		DistanceInfo distances(vertex_count, std::nullopt);
 
 #ifdef MULTITHREADING	/*We can't use shared containers safely*/
-		DistanceInfo distances(vertex_count, std::nullopt);
-		SearchHeap search_heap;
+		DijkstraHeap search_heap;
 #endif
+		search_heap.Reset(vertex_count);
 
-		search_heap.insert({ 0, from });
+		search_heap.Push(from, static_cast<Weight>(0));
 		distances[from] = static_cast<Weight>(0);
 
-		while (!search_heap.empty()) {
-			auto min_it{ search_heap.begin() };
-			const VertexId from_id{ min_it->second };
-			search_heap.erase(min_it);
+		/*Each vertex is settled once: its distance is final when it leaves the heap*/
+		while (!search_heap.Empty()) {
+			const auto [from_distance, from_id] { search_heap.Pop() };
 
-				const auto incidence_list{ graph.GetIncidentRange(from_id) };
-				for (const auto& [possibly_to_id, edge_id] : incidence_list) {
-					const Weight next_weight{ graph.GetEdge(edge_id).weight };
+			for (const EdgeId edge_id : graph.GetOutgoingEdges(from_id)) {				//Contiguous targets and weights
+				const VertexId possibly_to_id{ graph.GetTarget(edge_id) };
+				const Weight distance{ from_distance + graph.GetWeight(edge_id) };
 
-					if (!distances[possibly_to_id] || *distances[from_id] + next_weight < *distances[possibly_to_id]) {
-						distances[possibly_to_id] = *distances[from_id] + next_weight;
-						parents[possibly_to_id] = from_id;
+				if (!distances[possibly_to_id] || distance < *distances[possibly_to_id]) {
+					distances[possibly_to_id] = distance;
+					parents[possibly_to_id] = from_id;
 
-						search_heap.insert({ next_weight, possibly_to_id });
-					}
+					search_heap.Push(possibly_to_id, distance);
 				}
+			}
+		}
+		return { std::move(parents), std::move(distances) };
+	}
+
+	template <typename Graph>
+	void Navigator<Graph>::OnGraphUpdate(const std::vector<Edge>& removed_edges, const std::vector<Edge>& added_edges) {
+#ifdef MULTITHREADING
+		std::lock_guard cache_guard(mtx);
+		for (auto& [from, bucket] : parent_list_cache) {
+			std::lock_guard bucket_guard{ bucket.second };
+			if (bucket.first && !update_search_tree(std::addressof(*bucket.first), removed_edges, added_edges)) {
+				bucket.first.reset();
+			}
+		}
+#else
+		for (auto it = parent_list_cache.begin(); it != parent_list_cache.end();) {
+			if (update_search_tree(std::addressof(it->second), removed_edges, added_edges)) {
+				++it;
+			}
+			else {
+				it = parent_list_cache.erase(it);
+			}
+		}
+#endif
+	}
+
+	template <typename Graph>
+	bool Navigator<Graph>::update_search_tree(
+		SearchTree* tree, 
+		const std::vector<Edge>& removed_edges, 
+		const std::vector<Edge>& added_edges
+	) const {
+		auto& [parents, distances] { *tree };
+		const size_t known_count{ distances.size() };				//Vertices added after the search are unknown
+		for (const auto& edge : removed_edges) {
+			if (edge.to < known_count && parents[edge.to] == edge.from) {
+				return false;
+			}
+		}
+
+		/*The new paths are relaxed from the known vertices through the unknown ones only:
+		reaching a known vertex faster (or at all) changes the tree*/
+		std::unordered_map<VertexId, std::pair<Weight, VertexId>> unknown;	//Distance and parent
+		SearchHeap heap;
+		auto relax{ [&](VertexId from, VertexId to, Weight distance) {
+			if (to < known_count) {
+				return distances[to] && !(distance < *distances[to]);
+			}
+			auto [it, inserted] { unknown.try_emplace(to, distance, from) };
+			if (inserted || distance < it->second.first) {
+				it->second = { distance, from };
+				heap.insert({ distance, to });
+			}
+			return true;
+		} };
+
+		for (const auto& edge : added_edges) {
+			if (edge.from < known_count && distances[edge.from] && !relax(edge.from, edge.to, *distances[edge.from] + edge.weight)) {
+				return false;
+			}
+		}
+		while (!heap.empty()) {
+			const auto [distance, from_id] { *heap.begin() };
+			heap.erase(heap.begin());
+			for (const EdgeId edge_id : graph.GetOutgoingEdges(from_id)) {
+				if (!relax(from_id, graph.GetTarget(edge_id), distance + graph.GetWeight(edge_id))) {
+					return false;
+				}
+			}
+		}
+
+		parents.resize(graph.GetVertexCount(), std::nullopt);
+		distances.resize(graph.GetVertexCount(), std::nullopt);
+		for (const auto& [vertex, path] : unknown) {
+			distances[vertex] = path.first;
+			parents[vertex] = path.second;
 		}
-		return parents;
+		return true;
 	}
 
 	template <typename Weight>
@@ -196,7 +282,7 @@ namespace Graph {
 		Path path;
 		std::optional<VertexId> vertex_id{ to };
 
-		for (; vertex_id && *vertex_id != from; vertex_id = parents[*vertex_id]) {
+		for (; vertex_id && *vertex_id != from; vertex_id = *vertex_id < parents.size() ? parents[*vertex_id] : std::nullopt) {
 			path.push_back(*vertex_id);
 		}
 		if (!vertex_id) {
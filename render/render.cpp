@@ -22,8 +22,13 @@ namespace render {
 	}
 
 	template <>
-	svg::Color ExtractColor<string>(const string& color_str) {
-		return svg::Color(color_str);
+	svg::Color ExtractColor<Json::string_t>(const Json::string_t& color_str) {
+		return svg::Color(string(color_str));
+	}
+
+	template <>
+	svg::Color ExtractColor<Json::string_view_t>(const Json::string_view_t& color_str) {
+		return svg::Color(string(color_str));
 	}
 
 	template <>
@@ -0,0 +1,133 @@
+#include "answer_cache.h"
+#include "request.h"
+
+/*request_id splicing*/
+#include <array>
+#include <charconv>
+
+using namespace std;
+
+namespace request {
+	Json::Node AnswerCache::Serialized::Splice(uint64_t request_id) const {
+		array<char, 24> digits;
+		char* const last{ to_chars(digits.data(), digits.data() + digits.size(), request_id).ptr };
+
+		const string_view view{ text };
+		Json::string_t answer;
+		answer.reserve(text.size() + digits.size());
+		answer += view.substr(0, id_pos);
+		answer.append(digits.data(), last);
+		answer += view.substr(id_pos + 1);								//After the placeholder digit
+		return Json::Verbatim{ move(answer) };
+	}
+
+	bool AnswerCache::Answers::IsFresh(uint32_t id, uint64_t revision) const noexcept {
+		return id < revisions.size() && revisions[id] == revision;
+	}
+
+	AnswerCache::AnswerCache(Json::Format format_) noexcept : format{ format_ } {}
+
+	void AnswerCache::prepare(const TransportCatalog& tr_catalog_) {
+		is_built = false;
+		if (tr_catalog != addressof(tr_catalog_)) {
+			tr_catalog = addressof(tr_catalog_);
+			buses = Answers{};
+			stops = Answers{};
+		}
+
+		/*Only the ids without a fresh body are serialized (all of them for the first Build)*/
+		auto collect_stale{ [](Answers* answers, vector<string_view> names, auto find_id, auto get_revision) {
+			answers->stale.clear();
+			for (const auto name : names) {
+				const uint32_t id{ *find_id(name) };
+				if (id >= answers->bodies.size()) {
+					answers->bodies.resize(id + 1);
+					answers->revisions.resize(id + 1, unbuilt);
+				}
+				if (!answers->IsFresh(id, get_revision(id))) {
+					answers->stale.emplace_back(id, name);
+				}
+			}
+		} };
+		collect_stale(addressof(buses), tr_catalog->GetBusNames(),
+			[this](string_view name) { return tr_catalog->FindBusId(name); },
+			[this](uint32_t bus) { return tr_catalog->GetBusRevision(bus); });
+		collect_stale(addressof(stops), tr_catalog->GetStopNames(),
+			[this](string_view name) { return tr_catalog->FindStopId(name); },
+			[this](uint32_t stop) { return tr_catalog->GetStopRevision(stop); });
+
+		not_found = serialize(Read::MakeCachedError());
+	}
+
+	void AnswerCache::Build(const TransportCatalog& tr_catalog_) {
+		prepare(tr_catalog_);
+		for (const auto& [bus, name] : buses.stale) {
+			make_bus_body(bus, name);
+		}
+		for (const auto& [stop, name] : stops.stale) {
+			make_stop_body(stop, name);
+		}
+		is_built = true;
+	}
+
+#ifdef MULTITHREADING
+	algo::execution::Task<void> AnswerCache::BuildAsync(const TransportCatalog& tr_catalog_) {
+		prepare(tr_catalog_);
+		co_await algo::execution::async_for(buses.stale.begin(), buses.stale.end(), [this](const auto& item) {
+			make_bus_body(item.first, item.second);
+			});
+		co_await algo::execution::async_for(stops.stale.begin(), stops.stale.end(), [this](const auto& item) {
+			make_stop_body(item.first, item.second);
+			});
+		is_built = true;
+	}
+#endif
+
+	void AnswerCache::make_bus_body(uint32_t bus, string_view bus_name) {
+		buses.bodies[bus] = serialize(BusDatabase::MakeCachedAnswer(*tr_catalog, bus_name));
+		buses.revisions[bus] = tr_catalog->GetBusRevision(bus);
+	}
+
+	void AnswerCache::make_stop_body(uint32_t stop, string_view stop_name) {
+		stops.bodies[stop] = serialize(StopInfo::MakeCachedAnswer(*tr_catalog, stop_name));
+		stops.revisions[stop] = tr_catalog->GetStopRevision(stop);
+	}
+
+	optional<Json::Node> AnswerCache::FindBus(string_view bus_name, uint64_t request_id) const {
+		if (!is_built) {
+			return nullopt;
+		}
+		if (const auto bus = tr_catalog->FindBusId(bus_name)) {
+			return find(buses, *bus, tr_catalog->GetBusRevision(*bus), request_id);
+		}
+		return not_found.Splice(request_id);
+	}
+
+	optional<Json::Node> AnswerCache::FindStop(string_view stop_name, uint64_t request_id) const {
+		if (!is_built) {
+			return nullopt;
+		}
+		if (const auto stop = tr_catalog->FindStopId(stop_name)) {
+			return find(stops, *stop, tr_catalog->GetStopRevision(*stop), request_id);
+		}
+		return not_found.Splice(request_id);
+	}
+
+	optional<Json::Node> AnswerCache::find(const Answers& answers, uint32_t id, uint64_t revision, uint64_t request_id) const {
+		if (!answers.IsFresh(id, revision)) {
+			return nullopt;
+		}
+		return answers.bodies[id].Splice(request_id);
+	}
+
+	AnswerCache::Serialized AnswerCache::serialize(const Json::map_t& answer) const {
+		static constexpr string_view id_key{ "\"request_id\":" };
+		Serialized serialized;
+		Json::Writer(serialized.text, format).Write(answer);
+		serialized.id_pos = serialized.text.find(id_key) + id_key.size();	//A string value can't be followed by a colon
+		if (serialized.text[serialized.id_pos] == ' ') {
+			++serialized.id_pos;
+		}
+		return serialized;
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "transport_catalog.h"
+#include "json.h"
+
+/*Standart headers*/
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef MULTITHREADING
+#include "execution.h"
+#endif
+
+namespace request {
+	/*Serialized answers of Bus and Stop requests, built once the catalog is synchronized: the handlers only splice
+	request_id in. The bodies are indexed by the catalog ids and keep the revisions they were built at, so the entries
+	changed by the deltas are stale (the handlers answer them directly) until Build runs again and serializes only them*/
+	class AnswerCache {
+	public:
+		explicit AnswerCache(Json::Format format_ = Json::Format::PRETTY) noexcept;
+
+		void Build(const TransportCatalog& tr_catalog);
+#ifdef MULTITHREADING
+		/*Bodies are serialized on the pool*/
+		algo::execution::Task<void> BuildAsync(const TransportCatalog& tr_catalog);
+#endif
+
+		/*The answer with request_id spliced in. nullopt while the cache isn't built and for the stale entries
+		(the "not found" answer for the unknown names)*/
+		std::optional<Json::Node> FindBus(std::string_view bus_name, uint64_t request_id) const;
+		std::optional<Json::Node> FindStop(std::string_view stop_name, uint64_t request_id) const;
+	private:
+		static constexpr uint64_t unbuilt{ 0 };							//Catalog revisions start from 1
+
+		struct Serialized {
+			std::string text;
+			size_t id_pos{ 0 };											//Position of the request_id placeholder
+
+			Json::Node Splice(uint64_t request_id) const;
+		};
+
+		struct Answers {
+			std::vector<Serialized> bodies;								//Indexed by the catalog id
+			std::vector<uint64_t> revisions;
+			std::vector<std::pair<uint32_t, std::string_view>> stale;	//Ids and names to serialize
+
+			bool IsFresh(uint32_t id, uint64_t revision) const noexcept;
+		};
+
+		void prepare(const TransportCatalog& tr_catalog_);
+		void make_bus_body(uint32_t bus, std::string_view bus_name);
+		void make_stop_body(uint32_t stop, std::string_view stop_name);
+		std::optional<Json::Node> find(const Answers& answers, uint32_t id, uint64_t revision, uint64_t request_id) const;
+
+		/*The answers start with the request_id placeholder (see Read::MakeCachedError), it is found in the serialized answer*/
+		Serialized serialize(const Json::map_t& answer) const;
+	private:
+		Json::Format format;
+		const TransportCatalog* tr_catalog{ nullptr };
+		Answers buses, stops;
+		Serialized not_found;
+		bool is_built{ false };
+	};
+}
@@ -0,0 +1,167 @@
+#include "ingestion.h"
+
+using namespace std;
+
+namespace request {
+	StreamIngestion::StreamIngestion(string_view input_, TransportCatalog& tr_catalog_)
+		: input{ input_ }, tr_catalog{ tr_catalog_ }, arena{ make_unique<Json::Arena>() },
+		section_builder{ arena.get() }, root{ arena.get() }
+	{
+	}
+
+	void StreamIngestion::OnObjectStart() {
+		if (depth >= ROOT && !is_streamed()) {
+			section_builder.OnObjectStart();
+		}
+		open_container();
+	}
+
+	void StreamIngestion::OnObjectEnd() {
+		close_container();
+		if (depth >= ROOT && !is_streamed()) {
+			section_builder.OnObjectEnd();
+			if (depth == ROOT) {
+				collect_section(section_builder.Extract());
+			}
+		}
+		else if (is_streamed() && depth == SECTION) {
+			flush_record();
+		}
+	}
+
+	void StreamIngestion::OnArrayStart() {
+		if (depth >= ROOT && !is_streamed()) {
+			section_builder.OnArrayStart();
+		}
+		open_container();
+	}
+
+	void StreamIngestion::OnArrayEnd() {
+		close_container();
+		if (depth >= ROOT && !is_streamed()) {
+			section_builder.OnArrayEnd();
+			if (depth == ROOT) {
+				collect_section(section_builder.Extract());
+			}
+		}
+	}
+
+	void StreamIngestion::OnKey(string_view key) {
+		if (depth == ROOT) {
+			section = persist(key);
+		}
+		else if (!is_streamed()) {
+			section_builder.OnKey(key);
+		}
+		else if (depth == RECORD) {
+			field = persist(key);
+		}
+		else {
+			neighbour = persist(key);		//road_distances
+		}
+	}
+
+	void StreamIngestion::OnString(string_view value) {
+		if (!is_streamed()) {
+			section_builder.OnString(value);
+			if (depth == ROOT) {
+				collect_section(section_builder.Extract());
+			}
+		}
+		else if (depth == RECORD) {
+			if (field == "type") {
+				type = persist(value);
+			}
+			else if (field == "name") {
+				stop.name = persist(value);
+				bus.name = stop.name;
+			}
+		}
+		else if (depth == RECORD_FIELD && field == "stops") {
+			bus.stops.push_back(persist(value));
+		}
+	}
+
+	void StreamIngestion::OnNumber(Json::Number value) {
+		if (!is_streamed()) {
+			section_builder.OnNumber(value);
+			if (depth == ROOT) {
+				collect_section(section_builder.Extract());
+			}
+		}
+		else if (depth == RECORD) {
+			if (field == "latitude") {
+				stop.coordinates.latitude = value;
+			}
+			else if (field == "longitude") {
+				stop.coordinates.longitude = value;
+			}
+		}
+		else if (depth == RECORD_FIELD && field == "road_distances") {
+			stop.distances.insert({ neighbour, static_cast<uint64_t>(value) });
+		}
+	}
+
+	void StreamIngestion::OnBool(bool value) {
+		if (!is_streamed()) {
+			section_builder.OnBool(value);
+			if (depth == ROOT) {
+				collect_section(section_builder.Extract());
+			}
+		}
+		else if (depth == RECORD && field == "is_roundtrip") {
+			bus.is_roundtrip = value;
+		}
+	}
+
+	Json::Document StreamIngestion::ExtractDocument() {
+		return Json::Document(move(arena), Json::Node(move(root)));
+	}
+
+	bool StreamIngestion::is_streamed() const noexcept {
+		return section == "base_requests";
+	}
+
+	void StreamIngestion::open_container() {
+		if (is_streamed() && depth == SECTION) {		//New base request
+			type = {};
+			stop = {};
+			bus = {};
+		}
+		++depth;
+	}
+
+	void StreamIngestion::close_container() {
+		--depth;
+	}
+
+	void StreamIngestion::flush_record() {
+		if (type == "Stop") {
+			tr_catalog.AddStop(move(stop));
+		}
+		else if (type == "Bus") {
+			tr_catalog.AddBus(move(bus));
+		}
+		else {
+			throw invalid_argument("Invalid request type");
+		}
+	}
+
+	void StreamIngestion::collect_section(Json::Node section_root) {
+		root.emplace(Json::string_t(section), move(section_root));
+	}
+
+	string_view StreamIngestion::persist(string_view str) {
+		if (str.data() >= input.data() && str.data() + str.size() <= input.data() + input.size()) {
+			return str;
+		}
+		char* copy{ static_cast<char*>(arena->allocate(str.size(), alignof(char))) };
+		return string_view(copy, str.copy(copy, str.size()));
+	}
+
+	Json::Document IngestBaseRequests(string_view input, TransportCatalog& tr_catalog) {
+		StreamIngestion ingestion(input, tr_catalog);
+		Json::Parse(input, ingestion);
+		return ingestion.ExtractDocument();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "transport_catalog.h"
+#include "json.h"
+
+/*Standart headers*/
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace request {
+	/*Streams base_requests straight into the catalog (no JSON Tree and no handlers);
+	the remaining sections are collected into a JSON Tree*/
+	class StreamIngestion : public Json::ISaxHandler {
+	public:
+		StreamIngestion(std::string_view input_, TransportCatalog& tr_catalog_);
+
+		void OnObjectStart() override;
+		void OnObjectEnd() override;
+		void OnArrayStart() override;
+		void OnArrayEnd() override;
+		void OnKey(std::string_view key) override;
+		void OnString(std::string_view value) override;
+		void OnNumber(Json::Number value) override;
+		void OnBool(bool value) override;
+
+		/*Root map without base_requests (owns the decoded names passed to the catalog)*/
+		Json::Document ExtractDocument();
+	private:
+		/*Nesting levels*/
+		enum Depth : size_t {
+			ROOT = 1,
+			SECTION,
+			RECORD,
+			RECORD_FIELD
+		};
+
+		bool is_streamed() const noexcept;
+		void open_container();
+		void close_container();
+		void flush_record();
+		void collect_section(Json::Node section_root);
+
+		/*Views into the input are stable, decoded strings are copied to the arena*/
+		std::string_view persist(std::string_view str);
+	private:
+		std::string_view input;
+		TransportCatalog& tr_catalog;
+		std::unique_ptr<Json::Arena> arena;
+		size_t depth{ 0 };
+
+		/*Current root section*/
+		std::string_view section;
+		Json::Builder section_builder;
+		Json::map_t root;
+
+		/*Current base request*/
+		std::string_view field, type, neighbour;
+		geographic::Stop stop;
+		geographic::Bus bus;
+	};
+
+	/*Input and the document must outlive the catalog: names are views into them*/
+	Json::Document IngestBaseRequests(std::string_view input, TransportCatalog& tr_catalog);
+}
@@ -1,5 +1,7 @@
 #include "request.h"
 
+#include "answer_cache.h"
+
 /*Output with a given precision*/
 #include <iomanip>
 
@@ -12,8 +14,8 @@ namespace request {
 	}
 
 
-	Read::Read(Settings settings_, Type type_) noexcept
-		: Handler(type_), settings{ settings_ }, id{ 0 }
+	Read::Read(Settings settings_, Type type_, size_t position_) noexcept
+		: Handler(type_), settings{ settings_ }, id{ 0 }, position{ position_ }
 	{
 	}
 
@@ -21,41 +23,35 @@ namespace request {
 		id = request.AsMap().at("id").AsNumber();
 	}
 
+	Json::map_t Read::MakeCachedError() {
+		auto answer{ create_answer(0) };
+		add_error_message(addressof(answer));
+		return answer;
+	}
+
 	Read::Answer Read::create_answer() const {
-		//cout << id << '\n';
-		;
+		return create_answer(id);
+	}
+
+	Read::Answer Read::create_answer(uint64_t request_id) {
 		return Answer{
-				{
-				/*field name*/"request_id",
-				Json::Number(Json::NumberHolder{
-				/*negative*/ false,
-				/*whole*/ id,
-				/*fractional*/ 0,
-				/*fractional_length*/ 0
-				})
-		}
+			{ /*field name*/"request_id", Json::Number(request_id) }
 		};
 	}
 
-#ifdef MULTITHREADING
-	void Read::add_to_storage(Answer answer) {
-		settings.out.GetAccess().ref_to_value.push_back(Json::Node(move(answer)));
+	void Read::add_to_storage(Json::Node answer) {
+		settings.out[position] = move(answer);
 	}
-#else
-	void Read::add_to_storage(Answer answer) {
-		settings.out.emplace_back(move(answer));
-	}
-#endif
 
 	void Read::add_error_message(Answer* answer, string error_message) {
 		answer->insert({
 			"error_message",
-			move(error_message)
+			Json::string_t(error_message)
 			});
 	}
 
-	BusDatabase::BusDatabase(Settings settings_) noexcept
-		: Read(settings_, Type::BUS_INFO)
+	BusDatabase::BusDatabase(Settings settings_, size_t position_) noexcept
+		: Read(settings_, Type::BUS_INFO, position_)
 	{
 	}
 
@@ -65,23 +61,38 @@ namespace request {
 	}
 
 	void BusDatabase::Process() {
+		if (settings.answers) {
+			if (auto answer = settings.answers->FindBus(name, id)) {
+				add_to_storage(move(*answer));
+				return;
+			}
+		}
 		auto answer{ Read::create_answer() };
+		add_bus_info(addressof(answer), settings.tr_catalog, name);
+		add_to_storage(move(answer));
+	}
 
-		const auto bus_info{ settings.tr_catalog.GetBusInfo(name) };
+	Json::map_t BusDatabase::MakeCachedAnswer(const TransportCatalog& tr_catalog, string_view bus_name) {
+		auto answer{ create_answer(0) };
+		add_bus_info(addressof(answer), tr_catalog, bus_name);
+		return answer;
+	}
+
+	void BusDatabase::add_bus_info(Answer* answer, const TransportCatalog& tr_catalog, string_view bus_name) {
+		const auto bus_info{ tr_catalog.GetBusInfo(bus_name) };
 		if (!bus_info) {
-			add_error_message(addressof(answer));
+			add_error_message(answer);
 		}
 		else {
-			answer.insert({ "route_length", Json::Number(bus_info->distance.real) });
-			answer.insert({ "curvature", Json::Number(bus_info->distance.real / bus_info->distance.geographic) });
-			answer.insert({ "stop_count", Json::Number(static_cast<uint64_t>(bus_info->stops)) });
-			answer.insert({ "unique_stop_count", Json::Number(static_cast<uint64_t>(bus_info->unique_stops)) });
+			answer->insert({ "route_length", Json::Number(bus_info->distance.real) });
+			answer->insert({ "curvature", Json::Number(bus_info->distance.real / bus_info->distance.geographic) });
+			answer->insert({ "stop_count", Json::Number(static_cast<uint64_t>(bus_info->stops)) });
+			answer->insert({ "unique_stop_count", Json::Number(static_cast<uint64_t>(bus_info->unique_stops)) });
 		}
-		add_to_storage(move(answer));
 	}
 
-	StopInfo::StopInfo(Settings settings_) noexcept
-		: Read(settings_, Type::STOP_INFO)
+	StopInfo::StopInfo(Settings settings_, size_t position_) noexcept
+		: Read(settings_, Type::STOP_INFO, position_)
 	{
 	}
 
@@ -91,24 +102,39 @@ namespace request {
 	}
 
 	void StopInfo::Process() {
+		if (settings.answers) {
+			if (auto answer = settings.answers->FindStop(name, id)) {
+				add_to_storage(move(*answer));
+				return;
+			}
+		}
 		auto answer{ Read::create_answer() };
+		add_stop_info(addressof(answer), settings.tr_catalog, name);
+		add_to_storage(move(answer));
+	}
+
+	Json::map_t StopInfo::MakeCachedAnswer(const TransportCatalog& tr_catalog, string_view stop_name) {
+		auto answer{ create_answer(0) };
+		add_stop_info(addressof(answer), tr_catalog, stop_name);
+		return answer;
+	}
 
-		const auto stop_info{ settings.tr_catalog.GetStopInfo(name) };
+	void StopInfo::add_stop_info(Answer* answer, const TransportCatalog& tr_catalog, string_view stop_name) {
+		const auto stop_info{ tr_catalog.GetStopInfo(stop_name) };
 		if (!stop_info) {
-			add_error_message(addressof(answer));
+			add_error_message(answer);
 		}
 		else {
-			vector<Json::Node> buses;
+			Json::array_t buses;
 			for (auto bus : stop_info->range) {
-				buses.emplace_back(string(bus));
+				buses.emplace_back(Json::string_t(bus));
 			}
-			answer.insert({ "buses", move(buses) });
+			answer->insert({ "buses", move(buses) });
 		}
-		add_to_storage(move(answer));
 	}
 
-	RouteInfo::RouteInfo(Read::Settings settings_) noexcept
-		: Read(settings_, Type::ROUTE_INFO)
+	RouteInfo::RouteInfo(Read::Settings settings_, size_t position_) noexcept
+		: Read(settings_, Type::ROUTE_INFO, position_)
 	{
 	}
 
@@ -132,9 +158,9 @@ namespace request {
 		add_to_storage(move(answer));
 	}
 
-	vector<Json::Node> RouteInfo::combine_routings_items(const routing::OnMap& route_un_map) {
+	Json::array_t RouteInfo::combine_routings_items(const routing::OnMap& route_un_map) {
 		using routing::Point;
-		vector<Json::Node> items_storage;
+		Json::array_t items_storage;
 		for (const auto& point : route_un_map.items) {
 			if (point.type == Point::Type::WAIT) {
 				add_wait_info(addressof(items_storage), point);
@@ -146,21 +172,21 @@ namespace request {
 		return items_storage;
 	}
 
-	void RouteInfo::add_wait_info(vector<Json::Node>* storage, const routing::Point& wait) {
+	void RouteInfo::add_wait_info(Json::array_t* storage, const routing::Point& wait) {
 		storage->push_back(
 			Answer{
-			{"type", Json::Node("Wait"s)},
-			{"stop_name", Json::Node(string(wait.name))},
+			{"type", Json::Node(Json::string_t("Wait"))},
+			{"stop_name", Json::Node(Json::string_t(wait.name))},
 			{"time", Json::Node(Json::Number(wait.time)) }
 			}
 		);
 	}
 
-	void RouteInfo::add_trip_info(vector<Json::Node>* storage, const routing::Point& trip) {
+	void RouteInfo::add_trip_info(Json::array_t* storage, const routing::Point& trip) {
 		storage->push_back(
 			Answer{
-			{"type", Json::Node("Bus"s)},
-			{"bus", Json::Node(string(trip.name))},
+			{"type", Json::Node(Json::string_t("Bus"))},
+			{"bus", Json::Node(Json::string_t(trip.name))},
 			{"span_count", Json::Node(Json::Number(*trip.span_count))},
 			{"time", Json::Node(Json::Number(trip.time)) }
 			}
@@ -168,8 +194,8 @@ namespace request {
 	}
 
 #ifdef RENDER
-	Map::Map(Read::Settings settings_) noexcept
-		: Read(settings_, Type::MAP) 
+	Map::Map(Read::Settings settings_, size_t position_) noexcept
+		: Read(settings_, Type::MAP, position_)
 	{
 	}
 	void Map::Parse(const Json::Node& request) {
@@ -181,7 +207,7 @@ namespace request {
 		const auto& svg_doc{ settings.tr_catalog.GetMap() };
 		answer.insert({
 			"map",
-			Json::Node(svg_doc.Render())
+			Json::Node(Json::string_t(svg_doc.Render()))
 			});
 		add_to_storage(move(answer));
 	}
@@ -240,21 +266,21 @@ namespace request {
 	{
 	}
 
-	HandlerHolder ReadRequestFactory::Create(const Json::Node& request) const {
+	HandlerHolder ReadRequestFactory::Create(const Json::Node& request, size_t position) const {
 		const auto& type{ request.AsMap().at("type").AsString() };
 		HandlerHolder handler;
 		if (type == "Stop") {
-			handler = make_unique<StopInfo>(settings);
+			handler = make_unique<StopInfo>(settings, position);
 		}
 		else if (type == "Bus") {
-			handler = make_unique<BusDatabase>(settings);
+			handler = make_unique<BusDatabase>(settings, position);
 		}
 		else if (type == "Route"){
-			handler = make_unique<RouteInfo>(settings);
+			handler = make_unique<RouteInfo>(settings, position);
 		}
 #ifdef RENDER
 		else if(type == "Map") {
-			handler = make_unique<Map>(settings);
+			handler = make_unique<Map>(settings, position);
 		}
 #endif
 		else {
@@ -271,15 +297,18 @@ namespace request {
 	{
 	}
 
-	HandlerHolder ModifyRequestFactory::Create(const Json::Node& request) const {
+	HandlerHolder ModifyRequestFactory::Create(const Json::Node& request, size_t) const {
 		const auto& type{ request.AsMap().at("type").AsString() };
 		HandlerHolder handler;
 		if (type == "Stop") {
 			handler = make_unique<AddStop>(settings);
 		}
-		else {
+		else if (type == "Bus") {
 			handler = make_unique<AddBus>(settings);
-		}	
+		}
+		else {
+			throw std::invalid_argument("Invalid request type");
+		}
 
 		/*Updating handler internal data*/
 		handler->Parse(request);
@@ -2,16 +2,14 @@
 #include "transport_catalog.h"
 #include "json.h"
 
-#ifdef MULTITHREADING
-/*Synchronized access to the results store*/
-#include "synchronized.h"
-#endif
-
 /*Standart headers*/
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace request {
+	class AnswerCache;
+
 	enum class Type {
 		ADD_STOP,
 		ADD_BUS,
@@ -24,11 +22,9 @@ namespace request {
 
 	class Handler {
 	public:
-#ifdef MULTITHREADING
-		using Storage = Synchronized<std::vector<Json::Node>>;
-#else
-		using Storage = std::vector<Json::Node>;
-#endif
+		/*Answers in request order: it is sized in advance and each read handler
+		writes only its own slot, so no locks are needed*/
+		using Storage = Json::array_t;
 		const Type request_type;
 	public:
 		Handler(Type request_type_) noexcept;
@@ -47,13 +43,18 @@ namespace request {
 		struct Settings {
 			const TransportCatalog& tr_catalog;
 			Storage& out;
+			const AnswerCache* answers{ nullptr };	//Optional: Bus and Stop answers are spliced from it
 		};
 	public:
-		Read(Read::Settings settings, Type type_) noexcept;
+		Read(Read::Settings settings, Type type_, size_t position_) noexcept;
 		virtual void Parse(const Json::Node& request) = 0;
+
+		/*"not found" answer with the request_id placeholder (0), serialized once by AnswerCache*/
+		static Json::map_t MakeCachedError();
 	protected:
 		Settings settings;	//Handler settings (catalog and output)
 		uint64_t id;	//request_id
+		size_t position;	//Index of the request and of its answer slot
 		std::string_view name;	//bus or stop name
 	protected:
 		/*Answer type is std::decay_t<Json::Node::AsMap()>*/
@@ -61,44 +62,57 @@ namespace request {
 
 		/*Creates Json::map_t with request_id*/
 		Answer create_answer() const;
+		static Answer create_answer(uint64_t request_id);
 
-		/*Add answer to storage*/
-		void add_to_storage(Answer answer);
+		/*Puts answer (or the answer spliced by AnswerCache) to its slot of the storage*/
+		void add_to_storage(Json::Node answer);
 
 		static void add_error_message(Answer* answer, std::string error_message = "not found");
 	};
 
 	class BusDatabase : public Read {
 	public:
-		BusDatabase(Read::Settings settings_) noexcept;
+		BusDatabase(Read::Settings settings_, size_t position_) noexcept;
 		virtual void Process() override;
 		virtual void Parse(const Json::Node& request) override;
+
+		/*Answer with the request_id placeholder (0), serialized once by AnswerCache*/
+		static Json::map_t MakeCachedAnswer(const TransportCatalog& tr_catalog, std::string_view bus_name);
+	private:
+		/*Answer members except request_id*/
+		static void add_bus_info(Answer* answer, const TransportCatalog& tr_catalog, std::string_view bus_name);
 	};
 
 	class StopInfo : public Read {
 	public:
-		StopInfo(Read::Settings settings_) noexcept;
+		StopInfo(Read::Settings settings_, size_t position_) noexcept;
 		virtual void Process() override;
 		virtual void Parse(const Json::Node& request) override;
+
+		/*Answer with the request_id placeholder (0), serialized once by AnswerCache*/
+		static Json::map_t MakeCachedAnswer(const TransportCatalog& tr_catalog, std::string_view stop_name);
+	private:
+		/*Answer members except request_id*/
+		static void add_stop_info(Answer* answer, const TransportCatalog& tr_catalog, std::string_view stop_name);
 	};
 
 	class RouteInfo : public Read {
 	public:
-		RouteInfo(Read::Settings settings_) noexcept;
+		RouteInfo(Read::Settings settings_, size_t position_) noexcept;
 		virtual void Parse(const Json::Node& request) override;
 		virtual void Process() override;
 	protected:
 		routing::Bounds routing_stops;
 	private:
-		static std::vector<Json::Node> combine_routings_items(const routing::OnMap& route_un_map);
-		static void add_wait_info(std::vector<Json::Node>* storage, const routing::Point& wait);
-		static void add_trip_info(std::vector<Json::Node>* storage, const routing::Point& trip);
+		static Json::array_t combine_routings_items(const routing::OnMap& route_un_map);
+		static void add_wait_info(Json::array_t* storage, const routing::Point& wait);
+		static void add_trip_info(Json::array_t* storage, const routing::Point& trip);
 	};
 
 #ifdef RENDER
 	class Map : public Read {
 	public:
-		Map(Read::Settings settings_) noexcept;
+		Map(Read::Settings settings_, size_t position_) noexcept;
 		virtual void Parse(const Json::Node& request) override;
 		virtual void Process() override;
 	};
@@ -135,7 +149,8 @@ namespace request {
 	};
 
 	struct IFactory {
-		virtual HandlerHolder Create(const Json::Node& request) const = 0;
+		/*position is the index of the request in its section*/
+		virtual HandlerHolder Create(const Json::Node& request, size_t position) const = 0;
 		virtual ~IFactory() = default;
 	};
 
@@ -144,7 +159,7 @@ namespace request {
 	class ReadRequestFactory : public IFactory {
 	public:
 		ReadRequestFactory(Read::Settings settings_) noexcept;
-		virtual HandlerHolder Create(const Json::Node& request) const override;
+		virtual HandlerHolder Create(const Json::Node& request, size_t position) const override;
 	protected:
 		Read::Settings settings;
 	};
@@ -152,7 +167,7 @@ namespace request {
 	class ModifyRequestFactory : public IFactory {
 	public:
 		ModifyRequestFactory(Modify::Settings settings_) noexcept;
-		virtual HandlerHolder Create(const Json::Node& request)  const override;
+		virtual HandlerHolder Create(const Json::Node& request, size_t position) const override;
 	protected:
 		Modify::Settings settings;
 	};
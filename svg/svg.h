@@ -104,11 +104,7 @@ namespace svg {
 			return *this;
 		}
 		static std::string escape_string(std::string value) {
-#ifndef SVG_DEBUG
-			return "\\\"" + value + "\\\"";
-#else
 			return "\"" + value + "\"";
-#endif
 		}
 	private:
 		Color fill_color{ NoneColor }, stroke_color{ NoneColor };
@@ -275,6 +271,10 @@ namespace svg {
 		Document&& Add(Object&& object)&& {
 			return std::move(add_helper(std::move(object)));
 		}
+		Document& Merge(const Document& other)& {		//Objects of the other document are drawn on top
+			picture.insert(picture.end(), other.picture.begin(), other.picture.end());
+			return *this;
+		}
 
 		/*Rendering*/
 		std::string Render() const;
@@ -289,17 +289,9 @@ namespace svg {
 		std::vector<Object> picture;
 
 		static constexpr std::string_view
-#ifndef SVG_DEBUG
-			xml_header{ "<?xml version=\\\"1.0\\\" encoding=\\\"UTF-8\\\"?>" },
-			svg_header{ "<svg xmlns=\\\"http://www.w3.org/2000/svg\\\" version=\\\"1.1\\\">" },
-			svg_end{ "</svg>" };
-
-
-#else
 			xml_header{ "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" },
 			svg_header{ "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">" },
 			svg_end{ "</svg>" };
-#endif
 			
 	};
 }
\ No newline at end of file
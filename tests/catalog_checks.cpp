@@ -0,0 +1,100 @@
+#include "catalog_checks.h"
+#include "test_runner.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace tests {
+	namespace {
+		constexpr double tolerance{ 1e-6 };
+
+		bool is_close(double lhs, double rhs) noexcept {
+			return abs(lhs - rhs) <= tolerance * max(1.0, abs(rhs));
+		}
+
+		void assert_same_names(const vector<string_view>& actual, const vector<string_view>& expected, const string& hint) {
+			AssertEqual(actual.size(), expected.size(), hint + ": count");
+			for (size_t i = 0; i < expected.size(); ++i) {
+				AssertEqual(actual[i], expected[i], hint);
+			}
+		}
+	}
+
+	Requests MakeRequests(const generator::Network& network) {
+		Requests requests;
+		for (const auto& stop : network.stops) {
+			requests.stops.insert({ stop.name, stop });
+		}
+		for (const auto& bus : network.buses) {
+			requests.buses.insert({ bus.name, bus });
+		}
+		return requests;
+	}
+
+	unique_ptr<TransportCatalog> MakeCatalog() {
+		auto tr_catalog{ make_unique<TransportCatalog>() };
+		tr_catalog->SetRoutingSettings(generator::MakeRoutingSettings());
+#ifdef RENDER
+		tr_catalog->SetRenderSettings(generator::MakeRenderSettings());
+#endif
+		return tr_catalog;
+	}
+
+	unique_ptr<TransportCatalog> BuildCatalog(const Requests& requests) {
+		auto tr_catalog{ MakeCatalog() };
+		for (const auto& [name, stop] : requests.stops) {
+			tr_catalog->AddStop(stop);
+		}
+		for (const auto& [name, bus] : requests.buses) {
+			tr_catalog->AddBus(bus);
+		}
+		tr_catalog->Synchronize();
+		return tr_catalog;
+	}
+
+	void AssertSameAnswers(const TransportCatalog& actual, const Requests& requests, const string& step) {
+		const auto expected{ BuildCatalog(requests) };
+		const auto stop_names{ expected->GetStopNames() };
+		assert_same_names(actual.GetStopNames(), stop_names, step + ": stops");
+		assert_same_names(actual.GetBusNames(), expected->GetBusNames(), step + ": buses");
+
+		for (const auto& [name, bus] : requests.buses) {
+			const string hint{ step + ": Bus " + string(name) };
+			const auto actual_info{ actual.GetBusInfo(name) };
+			const auto expected_info{ expected->GetBusInfo(name) };
+			Assert(actual_info.has_value() && expected_info.has_value(), hint + " is found");
+			AssertEqual(actual_info->stops, expected_info->stops, hint + " stop_count");
+			AssertEqual(actual_info->unique_stops, expected_info->unique_stops, hint + " unique_stop_count");
+			Assert(is_close(actual_info->distance.real, expected_info->distance.real), hint + " route_length");
+			Assert(is_close(actual_info->distance.geographic, expected_info->distance.geographic), hint + " curvature");
+		}
+
+		for (const auto name : stop_names) {
+			const string hint{ step + ": Stop " + string(name) };
+			const auto actual_info{ actual.GetStopInfo(name) };
+			const auto expected_info{ expected->GetStopInfo(name) };
+			Assert(actual_info.has_value() && expected_info.has_value(), hint + " is found");
+			const vector<string_view> actual_buses(actual_info->range.begin(), actual_info->range.end());
+			const vector<string_view> expected_buses(expected_info->range.begin(), expected_info->range.end());
+			assert_same_names(actual_buses, expected_buses, hint + " buses");
+		}
+
+		for (const auto from : stop_names) {
+			for (const auto to : stop_names) {
+				const string hint{ step + ": Route " + string(from) + " -> " + string(to) };
+				const auto actual_route{ actual.GetRouting({ from, to }) };
+				const auto expected_route{ expected->GetRouting({ from, to }) };
+				AssertEqual(actual_route.has_value(), expected_route.has_value(), hint + " is found");
+				if (expected_route) {
+					Assert(is_close(actual_route->total_time, expected_route->total_time), hint + " total_time");
+				}
+			}
+		}
+
+#ifdef RENDER
+		Assert(actual.GetMap().Render() == expected->GetMap().Render(), step + ": map");
+#endif
+	}
+}
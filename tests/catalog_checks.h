@@ -0,0 +1,28 @@
+#pragma once
+#include "transport_catalog.h"
+#include "network_generator.h"
+
+/*Standart headers*/
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace tests {
+	/*Stops and buses of a catalog as requests (the names belong to a generator::Network):
+	the expected catalog is built from them from scratch*/
+	struct Requests {
+		std::map<std::string_view, geographic::Stop> stops;
+		std::map<std::string_view, geographic::Bus> buses;				//Round trips end with the first stop
+	};
+
+	Requests MakeRequests(const generator::Network& network);
+
+	/*The settings are the generator ones*/
+	std::unique_ptr<TransportCatalog> MakeCatalog();
+	std::unique_ptr<TransportCatalog> BuildCatalog(const Requests& requests);
+
+	/*Bus, Stop and Route answers (and the map) are the same as the ones of the catalog built from the requests.
+	Route times are compared with a tolerance: the same route may be summed over the edges in another order*/
+	void AssertSameAnswers(const TransportCatalog& actual, const Requests& requests, const std::string& step);
+}
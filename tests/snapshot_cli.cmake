@@ -0,0 +1,24 @@
+#Ключи командной строки --save-snapshot и --load-snapshot: ответы по загруженному снимку совпадают с ответами по base_requests
+#Параметры: GENERATOR, CATALOG (исполняемые файлы), WORK_DIR
+set(INPUT ${WORK_DIR}/snapshot_cli_input.json)
+set(SNAPSHOT ${WORK_DIR}/snapshot_cli.bin)
+
+execute_process(COMMAND ${GENERATOR} 60 20 200 7 OUTPUT_FILE ${INPUT} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "NetworkGenerator failed: ${result}")
+endif()
+
+execute_process(COMMAND ${CATALOG} --save-snapshot ${SNAPSHOT} ${INPUT} OUTPUT_VARIABLE saved RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "Saving the snapshot failed: ${result}")
+endif()
+
+execute_process(COMMAND ${CATALOG} --load-snapshot ${SNAPSHOT} ${INPUT} OUTPUT_VARIABLE loaded RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "Loading the snapshot failed: ${result}")
+endif()
+
+file(REMOVE ${INPUT} ${SNAPSHOT})
+if(NOT saved STREQUAL loaded)
+	message(FATAL_ERROR "The answers of the loaded snapshot differ")
+endif()
@@ -0,0 +1,269 @@
+#include "test_runner.h"
+#include "catalog_checks.h"
+#include "answer_cache.h"
+
+#include <iterator>
+#include <random>
+
+#ifdef MULTITHREADING
+#include <thread>
+#endif
+
+using namespace std;
+
+namespace {
+	generator::Parameters network_parameters{ .stop_count = 40, .bus_count = 12, .seed = 18 };
+
+	unique_ptr<TransportCatalog> build_from(const tests::Requests& requests) {
+		return tests::BuildCatalog(requests);
+	}
+
+	geographic::Bus as_loop(geographic::Bus bus) {
+		bus.stops.push_back(bus.stops.front());
+		bus.is_roundtrip = true;
+		return bus;
+	}
+
+	string cached_text(const optional<Json::Node>& answer) {
+		return answer ? string(get<Json::Verbatim>(answer->GetBase()).text) : string("stale");
+	}
+
+	/*Fresh cached answers are the same as the ones of a cache built from scratch, stale ones are not served*/
+	void assert_cache_is_consistent(request::AnswerCache& answers, const TransportCatalog& tr_catalog, const string& step) {
+		request::AnswerCache fresh;
+		fresh.Build(tr_catalog);
+		for (const auto name : tr_catalog.GetStopNames()) {
+			if (const auto answer = answers.FindStop(name, 1)) {
+				AssertEqual(cached_text(answer), cached_text(fresh.FindStop(name, 1)), step + ": Stop " + string(name));
+			}
+		}
+		for (const auto name : tr_catalog.GetBusNames()) {
+			if (const auto answer = answers.FindBus(name, 1)) {
+				AssertEqual(cached_text(answer), cached_text(fresh.FindBus(name, 1)), step + ": Bus " + string(name));
+			}
+		}
+
+		answers.Build(tr_catalog);
+		for (const auto name : tr_catalog.GetStopNames()) {
+			AssertEqual(cached_text(answers.FindStop(name, 1)), cached_text(fresh.FindStop(name, 1)), step + ": rebuilt Stop " + string(name));
+		}
+		for (const auto name : tr_catalog.GetBusNames()) {
+			AssertEqual(cached_text(answers.FindBus(name, 1)), cached_text(fresh.FindBus(name, 1)), step + ": rebuilt Bus " + string(name));
+		}
+	}
+}
+
+void TestScriptedDeltas() {
+	auto network{ generator::MakeNetwork(network_parameters) };
+	auto requests{ tests::MakeRequests(network) };
+
+	/*The first bus is added and the second one is extended by the deltas*/
+	const auto added_bus{ network.buses[0] };
+	auto extended_bus{ network.buses[1] };
+	extended_bus.stops.resize(2);
+	extended_bus.is_roundtrip = false;
+	requests.buses.erase(added_bus.name);
+	requests.buses[extended_bus.name] = extended_bus;
+	auto tr_catalog{ build_from(requests) };
+	tests::AssertSameAnswers(*tr_catalog, requests, "initial");
+
+	tr_catalog->UpdateBus(added_bus);
+	requests.buses[added_bus.name] = added_bus;
+	tests::AssertSameAnswers(*tr_catalog, requests, "add bus");
+
+	tr_catalog->UpdateBus(network.buses[1]);
+	requests.buses[network.buses[1].name] = network.buses[1];
+	tests::AssertSameAnswers(*tr_catalog, requests, "reroute bus");
+
+	const auto removed_bus{ network.buses[2] };
+	ASSERT(tr_catalog->RemoveBus(removed_bus.name));
+	ASSERT(!tr_catalog->RemoveBus("Unknown bus"));
+	requests.buses.erase(removed_bus.name);
+	tests::AssertSameAnswers(*tr_catalog, requests, "remove bus");
+
+	/*A new stop between two stops and a bus through it*/
+	const auto& first{ network.stops[0] };
+	const auto& second{ network.stops[5] };
+	geographic::Stop new_stop{
+		.name = network.AddName("New stop"),
+		.coordinates = {
+			(first.coordinates.latitude + second.coordinates.latitude) / 2,
+			(first.coordinates.longitude + second.coordinates.longitude) / 2
+		},
+		.distances = { { first.name, 1200 }, { second.name, 1500 } }
+	};
+	tr_catalog->UpdateStop(new_stop);
+	requests.stops[new_stop.name] = new_stop;
+	tests::AssertSameAnswers(*tr_catalog, requests, "add stop");
+
+	const geographic::Bus new_bus{ .name = network.AddName("New bus"), .stops = { first.name, new_stop.name, second.name } };
+	tr_catalog->UpdateBus(new_bus);
+	requests.buses[new_bus.name] = new_bus;
+	tests::AssertSameAnswers(*tr_catalog, requests, "add bus through the new stop");
+
+	/*The routes through the moved stop are laid again*/
+	auto moved_stop{ network.stops[2] };
+	moved_stop.coordinates.latitude += 0.01;
+	for (auto& [neighbour, distance] : moved_stop.distances) {
+		distance /= 2;
+	}
+	tr_catalog->UpdateStop(moved_stop);
+	requests.stops[moved_stop.name] = moved_stop;
+	tests::AssertSameAnswers(*tr_catalog, requests, "move stop");
+
+	/*The distance to an unknown stop is kept until the stop is added*/
+	auto declaring_stop{ network.stops[3] };
+	const auto late_name{ network.AddName("Late stop") };
+	declaring_stop.distances[late_name] = 700;
+	tr_catalog->UpdateStop(declaring_stop);
+	requests.stops[declaring_stop.name] = declaring_stop;
+	const geographic::Stop late_stop{ .name = late_name, .coordinates = declaring_stop.coordinates };
+	tr_catalog->UpdateStop(late_stop);
+	requests.stops[late_name] = late_stop;
+	const geographic::Bus late_bus{ .name = network.AddName("Late bus"), .stops = { late_name, declaring_stop.name } };
+	tr_catalog->UpdateBus(late_bus);
+	requests.buses[late_bus.name] = late_bus;
+	tests::AssertSameAnswers(*tr_catalog, requests, "pending distance");
+
+	/*A removed bus comes back*/
+	tr_catalog->UpdateBus(removed_bus);
+	requests.buses[removed_bus.name] = removed_bus;
+	tests::AssertSameAnswers(*tr_catalog, requests, "restore bus");
+}
+
+/*Random deltas: the unused items left by them must be compacted (all four arrays) without changing the answers*/
+void TestRandomDeltasAndCompaction() {
+	auto network{ generator::MakeNetwork(network_parameters) };
+	auto requests{ tests::MakeRequests(network) };
+	auto tr_catalog{ build_from(requests) };
+	request::AnswerCache answers;
+	answers.Build(*tr_catalog);
+
+	mt19937 random(network_parameters.seed);
+	auto pick{ [&random](auto& items) {
+		return next(items.begin(), random() % items.size());
+	} };
+	map<string_view, geographic::Bus> removed;
+	constexpr int iteration_count{ 300 };
+	for (int iteration = 0; iteration < iteration_count; ++iteration) {
+		const auto operation{ random() % 5 };
+		if (operation == 0 && requests.buses.size() > 1) {
+			const auto bus{ pick(requests.buses) };
+			ASSERT(tr_catalog->RemoveBus(bus->first));
+			removed.insert(*bus);
+			requests.buses.erase(bus);
+		}
+		else if (operation == 1 && !removed.empty()) {
+			const auto bus{ pick(removed) };
+			tr_catalog->UpdateBus(bus->second);
+			requests.buses.insert(*bus);
+			removed.erase(bus);
+		}
+		else if (operation == 2) {												//Reroute
+			auto bus{ pick(requests.buses)->second };
+			bus.stops.clear();
+			const size_t stop_count{ 2 + random() % 5 };
+			for (size_t i = 0; i < stop_count; ++i) {
+				bus.stops.push_back(pick(requests.stops)->first);
+			}
+			bus.is_roundtrip = random() % 2 == 0;
+			if (bus.is_roundtrip) {
+				bus.stops.push_back(bus.stops.front());
+			}
+			tr_catalog->UpdateBus(bus);
+			requests.buses[bus.name] = bus;
+		}
+		else if (operation == 3) {												//Move a stop and replace its distances
+			auto stop{ pick(requests.stops)->second };
+			stop.coordinates.latitude += (static_cast<int>(random() % 11) - 5) * 0.001;
+			stop.distances.clear();
+			if (const auto neighbour{ pick(requests.stops)->first }; neighbour != stop.name) {
+				stop.distances.insert({ neighbour, 500 + random() % 3000 });
+			}
+			if (random() % 2 == 0) {											//Maybe unknown yet
+				stop.distances.insert({ network.AddName("Ghost " + to_string(random() % 4)), 700 });
+			}
+			tr_catalog->UpdateStop(stop);
+			requests.stops[stop.name] = stop;
+		}
+		else {																	//Add or replace a ghost stop
+			const auto& base{ pick(requests.stops)->second };
+			geographic::Stop stop{
+				.name = network.AddName("Ghost " + to_string(random() % 4)),
+				.coordinates = { base.coordinates.latitude, base.coordinates.longitude + 0.002 },
+				.distances = { { base.name, 300 } }
+			};
+			tr_catalog->UpdateStop(stop);
+			requests.stops[stop.name] = stop;
+		}
+
+		if (iteration % 25 == 0) {
+			const string step{ "iteration " + to_string(iteration) };
+			tests::AssertSameAnswers(*tr_catalog, requests, step);
+			assert_cache_is_consistent(answers, *tr_catalog, step);
+		}
+	}
+	tests::AssertSameAnswers(*tr_catalog, requests, "final");
+	assert_cache_is_consistent(answers, *tr_catalog, "final");
+
+	const auto& compactions{ tr_catalog->GetCompactions() };
+	ASSERT(compactions.graphs > 0);
+	ASSERT(compactions.waybills > 0);
+	ASSERT(compactions.bus_lists > 0);
+	ASSERT(compactions.road_distances > 0);
+}
+
+#ifdef MULTITHREADING
+/*The first searches after the deltas update the graph once, the concurrent ones wait for it*/
+void TestConcurrentRoutingAfterDeltas() {
+	auto network{ generator::MakeNetwork(network_parameters) };
+	auto requests{ tests::MakeRequests(network) };
+	auto tr_catalog{ build_from(requests) };
+	tr_catalog->RemoveBus(network.buses[0].name);
+	requests.buses.erase(network.buses[0].name);
+	const auto bus{ as_loop(geographic::Bus{ .name = network.buses[1].name, .stops = { network.stops[0].name, network.stops[9].name } }) };
+	tr_catalog->UpdateBus(bus);
+	requests.buses[bus.name] = bus;
+
+	const auto stop_names{ tr_catalog->GetStopNames() };
+	auto search_all{ [&stop_names](const TransportCatalog& searched) {
+		vector<double> times;
+		for (const auto from : stop_names) {
+			for (const auto to : stop_names) {
+				const auto route{ searched.GetRouting({ from, to }) };
+				times.push_back(route ? route->total_time : -1);
+			}
+		}
+		return times;
+	} };
+	constexpr size_t thread_count{ 4 };
+	vector<vector<double>> results(thread_count);
+	vector<thread> threads;
+	for (size_t i = 0; i < thread_count; ++i) {
+		threads.emplace_back([&, i]() {
+			results[i] = search_all(*tr_catalog);
+			});
+	}
+	for (auto& searcher : threads) {
+		searcher.join();
+	}
+
+	const auto expected{ search_all(*build_from(requests)) };
+	for (const auto& times : results) {
+		ASSERT_EQUAL(times.size(), expected.size());
+		for (size_t i = 0; i < times.size(); ++i) {
+			ASSERT(abs(times[i] - expected[i]) < 1e-6);
+		}
+	}
+}
+#endif
+
+int main() {
+	TestRunner tr;
+	RUN_TEST(tr, TestScriptedDeltas);
+	RUN_TEST(tr, TestRandomDeltasAndCompaction);
+#ifdef MULTITHREADING
+	RUN_TEST(tr, TestConcurrentRoutingAfterDeltas);
+#endif
+	return 0;
+}
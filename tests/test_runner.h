@@ -0,0 +1,86 @@
+#pragma once
+
+/*Standart headers*/
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/*Unit testing framework in the spirit of the course one: a failed assertion throws, the runner reports it
+and the process exits with a non-zero code, so CTest marks the test as failed*/
+template <class T, class U>
+void AssertEqual(const T& t, const U& u, const std::string& hint = {}) {
+	if (!(t == u)) {
+		std::ostringstream os;
+		os << "Assertion failed: " << t << " != " << u;
+		if (!hint.empty()) {
+			os << " hint: " << hint;
+		}
+		throw std::runtime_error(os.str());
+	}
+}
+
+inline void Assert(bool b, const std::string& hint) {
+	AssertEqual(b, true, hint);
+}
+
+class TestRunner {
+public:
+	template <class TestFunc>
+	void RunTest(TestFunc func, const std::string& test_name) {
+		try {
+			func();
+			std::cerr << test_name << " OK" << std::endl;
+		}
+		catch (const std::exception& e) {
+			++fail_count;
+			std::cerr << test_name << " fail: " << e.what() << std::endl;
+		}
+		catch (...) {
+			++fail_count;
+			std::cerr << "Unknown exception caught" << std::endl;
+		}
+	}
+
+	~TestRunner() {
+		if (fail_count > 0) {
+			std::cerr << fail_count << " unit tests failed. Terminate" << std::endl;
+			std::exit(1);
+		}
+	}
+private:
+	int fail_count{ 0 };
+};
+
+#define ASSERT_EQUAL(x, y) {							\
+	std::ostringstream os__;							\
+	os__ << #x << " != " << #y << ", "					\
+		<< __FILE__ << ":" << __LINE__;				\
+	AssertEqual(x, y, os__.str());						\
+}
+
+#define ASSERT(x) {									\
+	std::ostringstream os__;							\
+	os__ << #x << " is false, "						\
+		<< __FILE__ << ":" << __LINE__;				\
+	Assert(x, os__.str());								\
+}
+
+/*Expects the statement to throw the exception type*/
+#define ASSERT_THROWS(statement, exception_type) {		\
+	bool is_thrown__{ false };							\
+	try {												\
+		statement;										\
+	}													\
+	catch (const exception_type&) {					\
+		is_thrown__ = true;								\
+	}													\
+	std::ostringstream os__;							\
+	os__ << #statement << " doesn't throw "			\
+		<< #exception_type << ", "						\
+		<< __FILE__ << ":" << __LINE__;				\
+	Assert(is_thrown__, os__.str());					\
+}
+
+#define RUN_TEST(tr, func) tr.RunTest(func, #func)
@@ -0,0 +1,194 @@
+#include "test_runner.h"
+#include "catalog_checks.h"
+#include "snapshot.h"
+#include "perfect_hash.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+using namespace std;
+
+namespace {
+	const string snapshot_path{ "test_snapshot.bin" };
+	const string corrupted_path{ "test_snapshot_corrupted.bin" };
+	const string reloaded_path{ "test_snapshot_reloaded.bin" };
+	const generator::Parameters network_parameters{ .stop_count = 40, .bus_count = 12, .seed = 19 };
+
+	/*Synchronized catalog changed by the deltas and saved: the snapshot has removed buses and pending distances*/
+	struct SavedCatalog {
+		generator::Network network;
+		tests::Requests requests;
+		std::unique_ptr<TransportCatalog> tr_catalog;
+		geographic::Bus removed_bus;
+		geographic::Stop late_stop;											//Declared by a stop, not added yet
+	};
+
+	SavedCatalog make_saved_catalog() {
+		SavedCatalog saved{ .network = generator::MakeNetwork(network_parameters) };
+		saved.requests = tests::MakeRequests(saved.network);
+		saved.tr_catalog = tests::BuildCatalog(saved.requests);
+
+		saved.removed_bus = saved.network.buses[0];
+		saved.tr_catalog->RemoveBus(saved.removed_bus.name);
+		saved.requests.buses.erase(saved.removed_bus.name);
+
+		auto declaring_stop{ saved.network.stops[1] };
+		saved.late_stop = geographic::Stop{ .name = saved.network.AddName("Late stop"), .coordinates = declaring_stop.coordinates };
+		declaring_stop.distances[saved.late_stop.name] = 900;
+		saved.tr_catalog->UpdateStop(declaring_stop);
+		saved.requests.stops[declaring_stop.name] = declaring_stop;
+
+		saved.tr_catalog->SaveSnapshot(snapshot_path);
+		return saved;
+	}
+
+	string read_file(const string& path) {
+		ifstream file(path, ios::binary);
+		return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	}
+
+	void write_file(const string& path, const string& bytes) {
+		ofstream file(path, ios::binary | ios::trunc);
+		file.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+	}
+
+	/*The checksum covers everything after the header (as snapshot::Writer computes it):
+	it is recomputed, so the corruption is left to the other checks*/
+	void reseal(string* image) {
+		snapshot::Header header;
+		memcpy(&header, image->data(), sizeof(header));
+		header.checksum = algo::hash::hash_string(string_view(*image).substr(sizeof(header)), snapshot::version);
+		memcpy(image->data(), &header, sizeof(header));
+	}
+
+	size_t get_entry_offset(snapshot::Section section) {
+		return sizeof(snapshot::Header) + section * sizeof(snapshot::SectionEntry);
+	}
+
+	snapshot::SectionEntry get_section(const string& image, snapshot::Section section) {
+		snapshot::SectionEntry entry;
+		memcpy(&entry, image.data() + get_entry_offset(section), sizeof(entry));
+		return entry;
+	}
+
+	void set_section(string* image, snapshot::Section section, snapshot::SectionEntry entry) {
+		memcpy(image->data() + get_entry_offset(section), &entry, sizeof(entry));
+	}
+
+	/*The rejected file leaves the catalog as it was*/
+	void assert_rejected(const SavedCatalog& saved, const string& image, const string& hint) {
+		write_file(corrupted_path, image);
+		auto tr_catalog{ tests::BuildCatalog(saved.requests) };
+		ASSERT_THROWS(tr_catalog->LoadSnapshot(corrupted_path), invalid_argument);
+		tests::AssertSameAnswers(*tr_catalog, saved.requests, hint);
+	}
+}
+
+void TestRoundTrip() {
+	auto saved{ make_saved_catalog() };
+	auto loaded{ tests::MakeCatalog() };
+	loaded->LoadSnapshot(snapshot_path);
+	tests::AssertSameAnswers(*loaded, saved.requests, "loaded");
+
+	/*The loaded catalog takes the deltas: the pending distance is resolved, the removed bus comes back*/
+	loaded->UpdateStop(saved.late_stop);
+	saved.requests.stops[saved.late_stop.name] = saved.late_stop;
+	const geographic::Bus late_bus{ .name = saved.network.AddName("Late bus"), .stops = { saved.network.stops[1].name, saved.late_stop.name } };
+	loaded->UpdateBus(late_bus);
+	saved.requests.buses[late_bus.name] = late_bus;
+	loaded->UpdateBus(saved.removed_bus);
+	saved.requests.buses[saved.removed_bus.name] = saved.removed_bus;
+	tests::AssertSameAnswers(*loaded, saved.requests, "deltas after loading");
+
+	/*The names of the reloaded catalog refer to the new file*/
+	loaded->SaveSnapshot(reloaded_path);
+	loaded->LoadSnapshot(reloaded_path);
+	tests::AssertSameAnswers(*loaded, saved.requests, "reloaded");
+}
+
+void TestFlippedByte() {
+	const auto saved{ make_saved_catalog() };
+	const string image{ read_file(snapshot_path) };
+	for (const size_t position : { get_entry_offset(snapshot::WAYBILL_STOPS), image.size() / 2, image.size() - 1 }) {
+		string corrupted{ image };
+		corrupted[position] ^= 1;
+		assert_rejected(saved, corrupted, "flipped byte " + to_string(position));
+	}
+}
+
+void TestWrongVersion() {
+	const auto saved{ make_saved_catalog() };
+	string image{ read_file(snapshot_path) };
+	snapshot::Header header;
+	memcpy(&header, image.data(), sizeof(header));
+	header.version = snapshot::version + 1;
+	memcpy(image.data(), &header, sizeof(header));
+	assert_rejected(saved, image, "wrong version");
+
+	string not_snapshot{ read_file(snapshot_path) };
+	not_snapshot[0] = 'X';
+	assert_rejected(saved, not_snapshot, "wrong magic");
+}
+
+void TestTruncatedFile() {
+	const auto saved{ make_saved_catalog() };
+	const string image{ read_file(snapshot_path) };
+	assert_rejected(saved, image.substr(0, image.size() - 8), "truncated");
+	assert_rejected(saved, image.substr(0, sizeof(snapshot::Header)), "header only");
+}
+
+void TestBadSectionBounds() {
+	const auto saved{ make_saved_catalog() };
+	const string image{ read_file(snapshot_path) };
+
+	/*The section goes past the end of the file*/
+	string out_of_file{ image };
+	auto entry{ get_section(out_of_file, snapshot::WAYBILL_STOPS) };
+	entry.size = out_of_file.size();
+	set_section(addressof(out_of_file), snapshot::WAYBILL_STOPS, entry);
+	reseal(addressof(out_of_file));
+	assert_rejected(saved, out_of_file, "section out of the file");
+
+	/*The size isn't a multiple of the record size*/
+	string partial_record{ image };
+	entry = get_section(partial_record, snapshot::WAYBILL_BOUNDS);
+	entry.size -= 1;
+	set_section(addressof(partial_record), snapshot::WAYBILL_BOUNDS, entry);
+	reseal(addressof(partial_record));
+	assert_rejected(saved, partial_record, "partial record");
+
+	/*A waybill slice goes past the waybill stops*/
+	string bad_slice{ image };
+	entry = get_section(bad_slice, snapshot::WAYBILL_BOUNDS);
+	snapshot::Bounds bounds;
+	memcpy(&bounds, bad_slice.data() + entry.offset, sizeof(bounds));
+	bounds.last = static_cast<uint32_t>(get_section(bad_slice, snapshot::WAYBILL_STOPS).size / sizeof(uint32_t) + 1);
+	memcpy(bad_slice.data() + entry.offset, &bounds, sizeof(bounds));
+	reseal(addressof(bad_slice));
+	assert_rejected(saved, bad_slice, "waybill slice out of the section");
+}
+
+void TestMissingFileAndUnsynchronizedCatalog() {
+	auto tr_catalog{ tests::MakeCatalog() };
+	ASSERT_THROWS(tr_catalog->LoadSnapshot("missing_snapshot.bin"), system_error);
+	ASSERT_THROWS(tr_catalog->SaveSnapshot(snapshot_path), logic_error);
+}
+
+int main() {
+	{
+		TestRunner tr;
+		RUN_TEST(tr, TestRoundTrip);
+		RUN_TEST(tr, TestFlippedByte);
+		RUN_TEST(tr, TestWrongVersion);
+		RUN_TEST(tr, TestTruncatedFile);
+		RUN_TEST(tr, TestBadSectionBounds);
+		RUN_TEST(tr, TestMissingFileAndUnsynchronizedCatalog);
+	}
+	filesystem::remove(snapshot_path);
+	filesystem::remove(corrupted_path);
+	filesystem::remove(reloaded_path);
+	return 0;
+}
@@ -0,0 +1,170 @@
+#include "snapshot.h"
+#include "perfect_hash.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SNAPSHOT_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace snapshot {
+	namespace {
+		constexpr size_t alignment{ 8 };
+
+		size_t align(size_t offset) noexcept {
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		uint64_t calc_checksum(const char* first, size_t length) noexcept {
+			return algo::hash::hash_string(string_view(first, length), version);
+		}
+
+		constexpr size_t payload_offset{ sizeof(Header) };
+		constexpr size_t sections_offset{ payload_offset + SECTION_COUNT * sizeof(SectionEntry) };
+	}
+
+	StringRef Writer::AddString(string_view str) {
+		const StringRef ref{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size()) };
+		strings.append(str);
+		return ref;
+	}
+
+	void Writer::Save(const string& path, uint32_t flags) const {
+		/*Section table and aligned sections (the string table is the first section)*/
+		array<SectionEntry, SECTION_COUNT> table{};
+		size_t offset{ sections_offset };
+		for (size_t section = 0; section < SECTION_COUNT; ++section) {
+			offset = align(offset);
+			table[section].offset = offset;
+			table[section].size = section == STRINGS ? strings.size() : sections[section].size();
+			offset += table[section].size;
+		}
+
+		string image(offset, '\0');
+		memcpy(image.data() + payload_offset, table.data(), sizeof(table));
+		for (size_t section = 0; section < SECTION_COUNT; ++section) {
+			const string& bytes{ section == STRINGS ? strings : sections[section] };
+			memcpy(image.data() + table[section].offset, bytes.data(), bytes.size());
+		}
+
+		const Header header{
+			magic,
+			version,
+			flags,
+			image.size(),
+			calc_checksum(image.data() + payload_offset, image.size() - payload_offset)
+		};
+		memcpy(image.data(), &header, sizeof(header));
+
+		ofstream file(path, ios::binary | ios::trunc);
+		file.write(image.data(), static_cast<streamsize>(image.size()));
+		if (!file.flush()) {
+			throw system_error(make_error_code(errc::io_error), "Snapshot: can't write the file");
+		}
+	}
+
+#ifdef SNAPSHOT_POSIX
+	unique_ptr<Reader> Reader::Open(const string& path) {
+		const int fd{ ::open(path.c_str(), O_RDONLY) };
+		if (fd < 0) {
+			throw system_error(errno, generic_category(), "Snapshot: can't open the file");
+		}
+		struct stat info {};
+		const bool is_regular{ ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) };
+		const size_t file_size{ is_regular ? static_cast<size_t>(info.st_size) : 0 };
+		if (file_size < sections_offset) {									//Pipes and empty files too
+			::close(fd);
+			throw invalid_argument("Snapshot: the file is truncated");
+		}
+		void* address{ ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0) };
+		const int mmap_error{ errno };
+		::close(fd);
+		if (address == MAP_FAILED) {
+			throw system_error(mmap_error, generic_category(), "Snapshot: mmap failed");
+		}
+
+		unique_ptr<Reader> reader(new Reader);
+		reader->data = static_cast<const char*>(address);
+		reader->size = file_size;
+		reader->is_mapped = true;
+		reader->validate();
+		return reader;
+	}
+
+	Reader::~Reader() {
+		if (is_mapped) {
+			::munmap(const_cast<char*>(data), size);
+		}
+	}
+#else
+	unique_ptr<Reader> Reader::Open(const string& path) {
+		ifstream file(path, ios::binary | ios::ate);
+		if (!file) {
+			throw system_error(make_error_code(errc::no_such_file_or_directory), "Snapshot: can't open the file");
+		}
+		unique_ptr<Reader> reader(new Reader);
+		reader->size = static_cast<size_t>(file.tellg());
+		reader->buffer = make_unique<char[]>(reader->size);				//Aligned for any record
+		reader->data = reader->buffer.get();
+		file.seekg(0);
+		file.read(reader->buffer.get(), static_cast<streamsize>(reader->size));
+		reader->validate();
+		return reader;
+	}
+
+	Reader::~Reader() = default;
+#endif
+
+	void Reader::validate() const {
+		if (size < sections_offset) {
+			throw invalid_argument("Snapshot: the file is truncated");
+		}
+		Header header;
+		memcpy(&header, data, sizeof(header));
+		if (header.magic != magic) {
+			throw invalid_argument("Snapshot: not a catalog snapshot");
+		}
+		if (header.version != version) {
+			throw invalid_argument("Snapshot: unsupported version");
+		}
+		if (header.file_size != size || header.checksum != calc_checksum(data + payload_offset, size - payload_offset)) {
+			throw invalid_argument("Snapshot: the file is corrupted");
+		}
+		for (size_t section = 0; section < SECTION_COUNT; ++section) {
+			SectionEntry entry;
+			memcpy(&entry, data + payload_offset + section * sizeof(SectionEntry), sizeof(entry));
+			if (entry.offset % alignment != 0 || entry.offset > size || entry.size > size - entry.offset) {
+				throw invalid_argument("Snapshot: section is out of the file");
+			}
+		}
+	}
+
+	uint32_t Reader::GetFlags() const noexcept {
+		Header header;
+		memcpy(&header, data, sizeof(header));
+		return header.flags;
+	}
+
+	span<const char> Reader::get_bytes(Section section) const {
+		SectionEntry entry;
+		memcpy(&entry, data + payload_offset + section * sizeof(SectionEntry), sizeof(entry));
+		return { data + entry.offset, static_cast<size_t>(entry.size) };
+	}
+
+	string_view Reader::GetString(StringRef ref) const {
+		const auto strings{ get_bytes(STRINGS) };
+		if (ref.offset > strings.size() || ref.length > strings.size() - ref.offset) {
+			throw invalid_argument("Snapshot: string is out of the string table");
+		}
+		return { strings.data() + ref.offset, ref.length };
+	}
+}
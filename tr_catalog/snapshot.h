@@ -0,0 +1,201 @@
+#pragma once
+
+/*Standart headers*/
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*Binary snapshot of a synchronized catalog.
+Layout: header, section table, sections. Positions are offsets from the beginning of the file,
+so the file can be mapped at any address. A section is an 8-byte aligned array of trivially copyable records*/
+namespace snapshot {
+	inline constexpr std::array<char, 8> magic{ 'T', 'R', 'C', 'A', 'T', 'S', 'N', 'P' };
+	inline constexpr uint32_t version{ 2 };								//2: the graph is saved in CSR form
+
+	enum Flags : uint32_t {
+		MAP_LAYOUT = 1														//Map indices are saved (RENDER build)
+	};
+
+	enum Section : uint32_t {
+		STRINGS,
+		ROUTING_SETTINGS,
+
+		/*Stops (indexed by stop id)*/
+		STOP_NAMES,
+		STOP_ORDER,
+		STOP_COORDINATES,
+		ROAD_DISTANCE_BOUNDS,
+		ROAD_DISTANCES,
+		ROOT_VERTICES,
+		BUS_PASSES,
+		BUS_LIST_BOUNDS,
+		BUS_LISTS,
+		MAP_INDICES,
+
+		/*Buses (indexed by bus id)*/
+		BUS_NAMES,
+		BUS_ORDER,
+		BUS_FLAGS,
+		WAYBILL_BOUNDS,
+		WAYBILL_STOPS,
+		WAYBILL_VERTICES,
+		ROUTE_STATS,
+
+		/*Graph in CSR form (indexed by vertex id and by edge id)*/
+		GRAPH_OFFSETS,
+		GRAPH_TARGETS,
+		GRAPH_WEIGHTS,
+		GRAPH_PAYLOADS,
+
+		/*Distances to the stops that aren't in the database yet*/
+		PENDING_DISTANCES,
+
+		SECTION_COUNT
+	};
+
+	struct Header {
+		std::array<char, 8> magic;
+		uint32_t version;
+		uint32_t flags;
+		uint64_t file_size;
+		uint64_t checksum;													//Of everything after the header
+	};
+
+	struct SectionEntry {
+		uint64_t offset;
+		uint64_t size;														//In bytes
+	};
+
+	/*Records*/
+	struct StringRef {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct Bounds {
+		uint32_t first;
+		uint32_t last;
+	};
+
+	struct RoutingSettings {
+		uint64_t bus_wait_time;
+		double bus_velocity;
+	};
+
+	struct Coordinates {
+		double latitude;
+		double longitude;
+	};
+
+	struct RoadDistance {
+		uint64_t distance;
+		uint32_t stop;
+		uint32_t reserved;
+	};
+
+	struct MapIndex {
+		uint64_t x_idx;
+		uint64_t y_idx;
+	};
+
+	enum BusFlags : uint8_t {
+		ROUNDTRIP = 1,
+		ACTIVE = 2
+	};
+
+	struct RouteStats {
+		uint64_t stops;
+		uint64_t unique_stops;
+		double geographic;
+		double real;
+	};
+
+	enum class EdgeKind : uint32_t {
+		TRANSFER,															//Bus vertex to root vertex, no data
+		WAIT,																//Owner is a stop
+		BUS																	//Owner is a bus
+	};
+
+	struct EdgePayload {
+		EdgeKind kind;
+		uint32_t owner;
+	};
+
+	struct PendingDistance {
+		StringRef name;
+		uint64_t distance;
+		uint32_t from;
+		uint32_t reserved;
+	};
+
+	/*Collects the sections and writes the file at once*/
+	class Writer {
+	public:
+		StringRef AddString(std::string_view str);
+
+		template <class Record>
+		void SetSection(Section section, const std::vector<Record>& records) {
+			static_assert(std::is_trivially_copyable_v<Record>);
+			sections[section].assign(
+				reinterpret_cast<const char*>(records.data()),
+				records.size() * sizeof(Record)
+			);
+		}
+
+		void Save(const std::string& path, uint32_t flags) const;
+	private:
+		std::string strings;
+		std::array<std::string, SECTION_COUNT> sections;
+	};
+
+	/*Read-only memory-mapped snapshot (read at once where mmap is unavailable).
+	The header, the checksum and the section bounds are checked when the file is opened.
+	Sections are viewed in place, so the reader must outlive the views*/
+	class Reader {
+	public:
+		static std::unique_ptr<Reader> Open(const std::string& path);
+
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+		~Reader();
+
+		uint32_t GetFlags() const noexcept;
+		std::string_view GetString(StringRef ref) const;
+
+		template <class Record>
+		std::span<const Record> View(Section section) const {
+			static_assert(std::is_trivially_copyable_v<Record>);
+			const auto bytes{ get_bytes(section) };
+			if (bytes.size() % sizeof(Record) != 0) {
+				throw std::invalid_argument("Snapshot: section size doesn't match its records");
+			}
+			return { reinterpret_cast<const Record*>(bytes.data()), bytes.size() / sizeof(Record) };
+		}
+
+		/*The section must have exactly record_count records*/
+		template <class Record>
+		std::span<const Record> View(Section section, size_t record_count) const {
+			const auto records{ View<Record>(section) };
+			if (records.size() != record_count) {
+				throw std::invalid_argument("Snapshot: unexpected number of records");
+			}
+			return records;
+		}
+	private:
+		Reader() = default;
+		void validate() const;
+		std::span<const char> get_bytes(Section section) const;
+	private:
+		std::unique_ptr<char[]> buffer;
+		const char* data{ nullptr };
+		size_t size{ 0 };
+		bool is_mapped{ false };
+	};
+}
@@ -8,22 +8,10 @@ using namespace std;
 
 TransportCatalog& TransportCatalog::AddStop(Stop stop_) {
 #ifdef MULTITHREADING
-	Guard stops_guard{ stops_mtx };	//lock_quard is faster than unique_lock
+	staging.Local().stops.push_back(move(stop_));		//No locks: the buffer belongs to the calling thread
+#else
+	staging.stops.push_back(move(stop_));
 #endif
-	stops.insert(
-		make_pair(
-			stop_.name,
-			StopHolder{
-				stop_.coordinates,
-				move(stop_.distances),
-				BusList{},
-				Navigation{},
-#ifdef RENDER
-				MapIndex{}
-#endif
-			}
-		)
-	);
 	return *this;
 }
 
@@ -32,66 +20,190 @@ TransportCatalog& TransportCatalog::AddBus(Bus bus_) {
 		bus_.stops.pop_back();							//Remove duplicate final stop
 	}
 #ifdef MULTITHREADING
-	Guard buses_guard{ buses_mtx };				//lock_quard is faster than unique_lock	
+	staging.Local().buses.push_back(move(bus_));		//The bus can go through stops that aren't yet in the database
+#else
+	staging.buses.push_back(move(bus_));
 #endif
-	buses.insert(		
-		make_pair(
-			bus_.name,
-			BusHolder{
-				move(bus_.stops),                              //The bus can go through stops that aren't yet in the database
-				bus_.is_roundtrip,
-				nullopt
-			}
-		)
-	);		
 	return *this;
 }
 
-Distance TransportCatalog::calc_distance(const StopsDatabase::value_type& first, const StopsDatabase::value_type& second) {
-	double geographic{
-		geographic::calc_distance(first.second.coordinates, second.second.coordinates)
-	};
-	return {
-		geographic,
-		calc_real_distance(first, second).value_or(geographic)
-	};
+optional<double> TransportCatalog::calc_real_distance(StopId first, StopId second) const {
+	auto find_distance{ [this](StopId from, StopId to) -> optional<double> {
+		const auto distances{ stops.GetRoadDistances(from) };
+		const auto it{ lower_bound(distances.begin(), distances.end(), to, [](const RoadDistance& item, StopId stop) {
+			return item.first < stop;
+			}) };
+		if (it != distances.end() && it->first == to) {
+			return static_cast<double>(it->second);
+		}
+		return nullopt;
+	} };
+	if (auto distance = find_distance(first, second)) {
+		return distance;
+	}
+	return find_distance(second, first);
+}
+
+void TransportCatalog::resize_segments() {
+	buses.forward_segments.resize(buses.waybill_stops.size());
+	buses.backward_segments.resize(buses.waybill_stops.size());
 }
 
-optional<double> TransportCatalog::calc_real_distance(const StopsDatabase::value_type& first, const StopsDatabase::value_type& second) {
-	const auto& first_distance_list{ first.second.distance_list },
-		second_distance_list{ second.second.distance_list };
-	if (auto it = first_distance_list.find(second.first);
-		it != first_distance_list.end()) {
-		return static_cast<double>(it->second);
+void TransportCatalog::set_segment_ends(BusId bus, span<StopId> ends) const {
+	const auto [first, last] { buses.waybill_bounds[bus] };
+	if (first == last) {
+		return;
 	}
-	if (auto it = second_distance_list.find(first.first);
-		it != second_distance_list.end()) {
-		return static_cast<double>(it->second);
+	copy(buses.waybill_stops.begin() + first + 1, buses.waybill_stops.begin() + last, ends.begin());
+	ends.back() = buses.is_roundtrip[bus] ?
+		buses.waybill_stops[first] :									//Roundtrip route is closed
+		buses.waybill_stops[last - 1];									//The final stop has no segment
+}
+
+vector<double> TransportCatalog::measure_geographic_lengths() const {
+	vector<StopId> ends(buses.waybill_stops);							//The unused waybill ranges lead nowhere
+	for (BusId bus = 0; bus < buses.Size(); ++bus) {
+		const auto [first, last] { buses.waybill_bounds[bus] };
+		set_segment_ends(bus, span(ends).subspan(first, last - first));
+	}
+	vector<double> lengths(ends.size());
+	geographic::calc_distances(stops.trig, buses.waybill_stops, ends, lengths);
+	return lengths;
+}
+
+void TransportCatalog::measure_segments(BusId bus, span<const double> lengths) {
+	const auto [first, last] { buses.waybill_bounds[bus] };
+	if (first == last) {
+		return;
+	}
+
+	/*Geographic length is the same in both directions, the real one may differ*/
+	const bool is_roundtrip{ buses.is_roundtrip[bus] };
+	for (uint32_t pos = first; pos + 1 < last; ++pos) {
+		const StopId stop{ buses.waybill_stops[pos] },
+			next_stop{ buses.waybill_stops[pos + 1] };
+		const double length{ lengths[pos - first] };
+		buses.forward_segments[pos] = { length, calc_real_distance(stop, next_stop).value_or(length) };
+		buses.backward_segments[pos] = is_roundtrip ?
+			Distance{} :
+			Distance{ length, calc_real_distance(next_stop, stop).value_or(length) };
+	}
+	const double closing_length{ lengths[last - 1 - first] };
+	buses.forward_segments[last - 1] = is_roundtrip ?
+		Distance{
+			closing_length,
+			calc_real_distance(buses.waybill_stops[last - 1], buses.waybill_stops[first]).value_or(closing_length)
+		} :
+		Distance{};
+	buses.backward_segments[last - 1] = Distance{};
+}
+
+void TransportCatalog::measure_segments(BusId bus) {
+	const auto [first, last] { buses.waybill_bounds[bus] };
+	const Waybill waybill{ buses.GetWaybill(bus) };
+	vector<StopId> ends(waybill.size());
+	set_segment_ends(bus, ends);
+	vector<double> lengths(ends.size());
+	geographic::calc_distances(stops.trig, waybill, ends, lengths);
+	measure_segments(bus, lengths);
+}
+
+void TransportCatalog::measure_all_segments() {
+	resize_segments();
+	const auto lengths{ measure_geographic_lengths() };
+	for (BusId bus = 0; bus < buses.Size(); ++bus) {
+		const auto [first, last] { buses.waybill_bounds[bus] };
+		measure_segments(bus, span(lengths).subspan(first, last - first));
 	}
-	return nullopt;
 }
 
 optional<Route> TransportCatalog::GetBusInfo(string_view bus_name_) const {
-	auto bus_it{ buses.find(bus_name_) };
-	if (bus_it == buses.end()) {
+	const auto bus{ find_bus(bus_name_) };
+	if (!bus || !buses.is_active[*bus]) {
 		return nullopt;
 	}
-	return get_bus_route_stats(bus_it);
+	return get_bus_route_stats(*bus);
 }
 
 optional<stats::Stop<TransportCatalog::BusListIt>> TransportCatalog::GetStopInfo(string_view stop_name_) const {
-	auto stop_it{ stops.find(stop_name_) };
-	if (stop_it == stops.end()) {
+	const auto stop{ find_stop(stop_name_) };
+	if (!stop) {
 		return nullopt;
 	}
+	const auto [first, last] { stops.bus_bounds[*stop] };
 	return stats::Stop<BusListIt>{
 		Range(
-			stop_it->second.bus_list.begin(),
-			stop_it->second.bus_list.end()
+			stops.bus_names.cbegin() + first,
+			stops.bus_names.cbegin() + last
 		)
 	};
 }
 
+vector<string_view> TransportCatalog::GetStopNames() const {
+	vector<string_view> names;
+	names.reserve(stops.by_name.size());
+	for (const auto stop : stops.by_name) {
+		names.push_back(stops.names[stop]);
+	}
+	return names;
+}
+
+vector<string_view> TransportCatalog::GetBusNames() const {
+	vector<string_view> names;
+	names.reserve(buses.by_name.size());
+	for (const auto bus : buses.by_name) {
+		names.push_back(buses.names[bus]);
+	}
+	return names;
+}
+
+optional<TransportCatalog::StopId> TransportCatalog::FindStopId(string_view stop_name_) const {
+	return find_stop(stop_name_);
+}
+
+optional<TransportCatalog::BusId> TransportCatalog::FindBusId(string_view bus_name_) const {
+	const auto bus{ find_bus(bus_name_) };
+	if (!bus || !buses.is_active[*bus]) {
+		return nullopt;
+	}
+	return bus;
+}
+
+uint64_t TransportCatalog::GetStopRevision(StopId stop) const noexcept {
+	return stop_revisions[stop];
+}
+
+uint64_t TransportCatalog::GetBusRevision(BusId bus) const noexcept {
+	return bus_revisions[bus];
+}
+
+optional<TransportCatalog::StopId> TransportCatalog::find_stop(string_view stop_name) const {
+	if (auto stop = stop_ids.Find(stop_name)) {
+		return stop;
+	}
+	if (auto it = added_stop_ids.find(stop_name); it != added_stop_ids.end()) {
+		return it->second;
+	}
+	return nullopt;
+}
+
+optional<TransportCatalog::BusId> TransportCatalog::find_bus(string_view bus_name) const {
+	if (auto bus = bus_ids.Find(bus_name)) {
+		return bus;
+	}
+	if (auto it = added_bus_ids.find(bus_name); it != added_bus_ids.end()) {
+		return it->second;
+	}
+	return nullopt;
+}
+
+TransportCatalog::StopId TransportCatalog::get_stop(string_view stop_name) const {
+	if (auto stop = find_stop(stop_name)) {
+		return *stop;
+	}
+	throw out_of_range("Unknown stop");
+}
+
 void TransportCatalog::SetRoutingSettings(const routing::Parameters& routing_settings_) {
 	routing_settings = make_unique<routing::Parameters>(routing_settings_);
 }
@@ -102,208 +214,523 @@ void TransportCatalog::SetRenderSettings(render::Settings render_settings_) {
 }
 #endif
 
-void TransportCatalog::Synchronize() {
+namespace {
+	/*Writes the duration of the scope*/
+	class StageTimer {
+	public:
+		explicit StageTimer(chrono::nanoseconds& duration_) noexcept
+			: duration{ duration_ }, start{ chrono::steady_clock::now() } {
+		}
+		~StageTimer() {
+			duration = chrono::steady_clock::now() - start;
+		}
+	private:
+		chrono::nanoseconds& duration;
+		chrono::steady_clock::time_point start;
+	};
+}
+
 #ifdef MULTITHREADING
-	Guard stops_guard{ stops_mtx };
-	Guard buses_guard{ buses_mtx };
+void TransportCatalog::Synchronize() {
+	algo::execution::sync_wait(SynchronizeAsync());
+}
+
+algo::execution::Task<void> TransportCatalog::SynchronizeAsync() {
+	using algo::execution::Task;
+	const StageTimer total_timer{ sync_timings[TOTAL] };
+	intern_staged();													//AddStop and AddBus must not run concurrently with Synchronize
+	{
+		const StageTimer timer{ sync_timings[SEGMENTS] };
+		resize_segments();
+		const auto lengths{ measure_geographic_lengths() };
+		co_await for_each_id<BusId>(buses.Size(), [this, &lengths](BusId bus) {
+			const auto [first, last] { buses.waybill_bounds[bus] };
+			measure_segments(bus, span(lengths).subspan(first, last - first));
+			});
+	}
+
+	/*Route stats depend only on the waybills and distances*/
+	vector<Task<void>> stages;
+	stages.push_back(calculate_all_routes_stats());
+	stages.push_back(build_navigation());
+	co_await algo::execution::when_all(move(stages));
+}
+
+algo::execution::Task<void> TransportCatalog::build_navigation() {
+	{
+		const StageTimer timer{ sync_timings[TYING] };
+		tie_stops_with_buses();
+	}
+	const size_t graph_size{ initialize_vertices() };
+
+	/*The map layout depends only on the coordinates and the waybills*/
+	vector<algo::execution::Task<void>> stages;
+	stages.push_back(build_graph(graph_size));
+#ifdef RENDER
+	stages.push_back(layout_map());
 #endif
-	tie_stops_with_buses();
-	const size_t graph_size{ 
-		initialize_root_vertex_index(addressof(stops)) 
-	};
+	co_await algo::execution::when_all(move(stages));
+}
 
-	graph = make_graph(graph_size);
-	navigator = make_unique<Navigator>(*graph);
+algo::execution::Task<void> TransportCatalog::build_graph(size_t vertex_count) {
+	{
+		const StageTimer timer{ sync_timings[GRAPH] };
+		vector<vector<Edge>> route_edges(buses.Size());
+		co_await for_each_id<BusId>(buses.Size(), [this, &route_edges](BusId bus) {
+			route_edges[bus] = make_route_edges(bus);
+			});
+		graph_builder.reset();
+		graph = make_graph(vertex_count, route_edges);
+	}
+	{
+		const StageTimer timer{ sync_timings[NAVIGATOR] };
+		navigator = make_unique<Navigator>(*graph);
+	}
+	const StageTimer timer{ sync_timings[COMPONENTS] };
+	co_await find_components();
+}
+
+algo::execution::Task<void> TransportCatalog::find_components() {
+	using ComponentId = Graph::Components::ComponentId;
+
+	/*Strong and weak components are independent searches*/
+	vector<ComponentId> strong, weak;
+	vector<algo::execution::Task<void>> searches;
+	searches.push_back(run_on_pool([this, &strong]() {
+		strong = Graph::Components::FindStrong(*graph);
+		}));
+	searches.push_back(run_on_pool([this, &weak]() {
+		weak = Graph::Components::FindWeak(*graph);
+		}));
+	co_await algo::execution::when_all(move(searches));
+	components = Graph::Components(move(strong), move(weak));
+}
+
+#ifdef RENDER
+algo::execution::Task<void> TransportCatalog::layout_map() {
+	collect_route_neighbours();
+
+	/*The axes are compressed independently*/
+	MapIndex max_idx;
+	stops.map_indices.assign(stops.Size(), MapIndex{});
+	vector<algo::execution::Task<void>> axes;
+	axes.push_back(run_on_pool([this, &max_idx]() {
+		const StageTimer timer{ sync_timings[MAP_X_AXIS] };
+		max_idx.x_idx = distribute_stops_on_x_axis();
+		}));
+	axes.push_back(run_on_pool([this, &max_idx]() {
+		const StageTimer timer{ sync_timings[MAP_Y_AXIS] };
+		max_idx.y_idx = distribute_stops_on_y_axis();
+		}));
+	co_await algo::execution::when_all(move(axes));
+	step_info = calculate_step_settings(max_idx);
+}
+#endif
+#else
+void TransportCatalog::Synchronize() {
+	const StageTimer total_timer{ sync_timings[TOTAL] };
+	intern_staged();
+	{
+		const StageTimer timer{ sync_timings[SEGMENTS] };
+		measure_all_segments();
+	}
+	{
+		const StageTimer timer{ sync_timings[TYING] };
+		tie_stops_with_buses();
+	}
+	const size_t graph_size{ initialize_vertices() };
+
+	{
+		const StageTimer timer{ sync_timings[GRAPH] };
+		vector<vector<Edge>> route_edges(buses.Size());
+		for (BusId bus = 0; bus < buses.Size(); ++bus) {
+			route_edges[bus] = make_route_edges(bus);
+		}
+		graph_builder.reset();
+		graph = make_graph(graph_size, route_edges);
+	}
+	{
+		const StageTimer timer{ sync_timings[NAVIGATOR] };
+		navigator = make_unique<Navigator>(*graph);
+	}
+	{
+		const StageTimer timer{ sync_timings[COMPONENTS] };
+		components = Graph::Components(*graph);
+	}
+#ifdef RENDER
+	collect_route_neighbours();
+	MapIndex max_idx;
+	stops.map_indices.assign(stops.Size(), MapIndex{});
+	{
+		const StageTimer timer{ sync_timings[MAP_X_AXIS] };
+		max_idx.x_idx = distribute_stops_on_x_axis();
+	}
+	{
+		const StageTimer timer{ sync_timings[MAP_Y_AXIS] };
+		max_idx.y_idx = distribute_stops_on_y_axis();
+	}
+	step_info = calculate_step_settings(max_idx);
+#endif
+}
+#endif
+
+vector<TransportCatalog::SyncStageTiming> TransportCatalog::GetSyncStats() const {
+	static constexpr array<string_view, SYNC_STAGE_COUNT> stage_names{
+		"interning",
+		"road_segments",
+		"tie_stops_with_buses",
+		"make_graph",
+		"navigator",
+		"components",
 #ifdef MULTITHREADING
-	calculate_all_routes_stats();
+		"route_stats",
 #endif
 #ifdef RENDER
-	const auto max_idx{ 
-		distribute_stops_on_map()								//The graph must be initialized to allocate stops on map
+		"map_x_axis",
+		"map_y_axis",
+#endif
+		"total"
 	};
-	step_info = calculate_step_settings(max_idx);
+	vector<SyncStageTiming> timings;
+	timings.reserve(SYNC_STAGE_COUNT);
+	for (size_t stage = 0; stage < SYNC_STAGE_COUNT; ++stage) {
+		timings.push_back({
+			stage_names[stage],
+			chrono::duration_cast<chrono::microseconds>(sync_timings[stage])
+			});
+	}
+	return timings;
+}
+
+bool TransportCatalog::IsSynchronized() const noexcept {
+	return navigator != nullptr;
+}
+
+void TransportCatalog::intern_staged() {
+	if (IsSynchronized()) {													//The tables are interned once, later changes are deltas
+		throw logic_error("The catalog is already synchronized: use UpdateStop, UpdateBus and RemoveBus");
+	}
+	const StageTimer timer{ sync_timings[INTERNING] };
+	Staging staged{ take_staged() };
+	intern_stops(staged.stops, staged.buses);							//Stops first: waybills are converted to stop ids
+	intern_buses(move(staged.buses));
+	reset_revisions();
+	reset_delta_state();
+}
+
+#ifdef MULTITHREADING
+TransportCatalog::Staging TransportCatalog::take_staged() {
+	/*Thread buffers are merged once*/
+	size_t stop_count{ 0 }, bus_count{ 0 };
+	staging.ForEach([&stop_count, &bus_count](const Staging& buffer) {
+		stop_count += buffer.stops.size();
+		bus_count += buffer.buses.size();
+		});
+
+	Staging merged;
+	merged.stops.reserve(stop_count);
+	merged.buses.reserve(bus_count);
+	staging.ForEach([&merged](Staging& buffer) {
+		move(buffer.stops.begin(), buffer.stops.end(), back_inserter(merged.stops));
+		move(buffer.buses.begin(), buffer.buses.end(), back_inserter(merged.buses));
+		});
+	staging.Clear();
+	return merged;
+}
+#else
+TransportCatalog::Staging TransportCatalog::take_staged() {
+	return exchange(staging, Staging{});
+}
 #endif
+
+void TransportCatalog::intern_stops(const vector<Stop>& new_stops, const vector<Bus>& new_buses) {
+	/*Stops mentioned only in waybills are in the database too (with default coordinates)*/
+	vector<string_view> names;
+	names.reserve(new_stops.size());
+	for (const auto& stop : new_stops) {
+		names.push_back(stop.name);
+	}
+	for (const auto& bus : new_buses) {
+		names.insert(names.end(), bus.stops.begin(), bus.stops.end());
+	}
+	sort(names.begin(), names.end());									//Alphabetical ids keep the map rendering order
+	names.erase(unique(names.begin(), names.end()), names.end());
+
+	stops.names = move(names);
+	stop_ids = NameIndex<StopId>(stops.names);
+	stops.by_name.resize(stops.Size());
+	iota(stops.by_name.begin(), stops.by_name.end(), StopId{ 0 });
+	stops.coordinates.assign(stops.Size(), {});
+	stops.distance_bounds.assign(stops.Size(), Bounds{ 0, 0 });
+	stops.road_distances.clear();
+
+	vector<bool> is_added(stops.Size(), false);
+	for (const auto& stop : new_stops) {
+		const StopId id{ stop_ids.At(stop.name) };
+		if (!is_added[id]) {												//The first description of the stop is used
+			is_added[id] = true;
+			stops.coordinates[id] = stop.coordinates;
+			set_road_distances(id, make_road_distances(id, stop.distances));
+		}
+	}
+	stops.trig.Assign(stops.coordinates);
+}
+
+TransportCatalog::RoadDistances TransportCatalog::make_road_distances(StopId stop, const geographic::DistanceList& distances) {
+	RoadDistances road_distances;
+	road_distances.reserve(distances.size());
+	for (const auto& [neighbour, distance] : distances) {
+		if (auto neighbour_stop = find_stop(neighbour)) {
+			road_distances.emplace_back(*neighbour_stop, distance);
+		}
+		else {																//The stop can be added later by UpdateStop
+			add_pending_distance(stop, neighbour, distance);
+		}
+	}
+	return road_distances;
+}
+
+void TransportCatalog::set_road_distances(StopId stop, RoadDistances distances) {
+	sort(distances.begin(), distances.end());							//Neighbours are unique: binary search by id
+	garbage.road_distances += stops.distance_bounds[stop].second - stops.distance_bounds[stop].first;
+	const auto first{ static_cast<uint32_t>(stops.road_distances.size()) };
+	stops.road_distances.insert(stops.road_distances.end(), distances.begin(), distances.end());
+	stops.distance_bounds[stop] = { first, static_cast<uint32_t>(stops.road_distances.size()) };
 }
 
+void TransportCatalog::intern_buses(vector<Bus> new_buses) {
+	stable_sort(new_buses.begin(), new_buses.end(), [](const Bus& lhs, const Bus& rhs) {
+		return lhs.name < rhs.name;
+		});
+	new_buses.erase(
+		unique(new_buses.begin(), new_buses.end(), [](const Bus& lhs, const Bus& rhs) {
+			return lhs.name == rhs.name;										//The first description of the bus is used
+			}),
+		new_buses.end()
+	);
+
+	const size_t bus_count{ new_buses.size() };
+	buses.names.reserve(bus_count);
+	buses.is_roundtrip.reserve(bus_count);
+	buses.waybill_bounds.reserve(bus_count);
+	for (const auto& bus : new_buses) {
+		const auto first{ static_cast<uint32_t>(buses.waybill_stops.size()) };
+		buses.names.push_back(bus.name);
+		buses.is_roundtrip.push_back(bus.is_roundtrip);
+		for (const auto stop : bus.stops) {
+			buses.waybill_stops.push_back(stop_ids.At(stop));
+		}
+		buses.waybill_bounds.emplace_back(first, static_cast<uint32_t>(buses.waybill_stops.size()));
+	}
+	bus_ids = NameIndex<BusId>(buses.names);
+	buses.by_name.resize(bus_count);
+	iota(buses.by_name.begin(), buses.by_name.end(), BusId{ 0 });
+	buses.is_active.assign(bus_count, true);
+	buses.stats.assign(bus_count, nullopt);
+}
 
 void TransportCatalog::tie_stops_with_buses() {
-	for (const auto& [id, bus_info] : buses) {
-		for (const auto& stop : bus_info.waybill) {
-			auto& stop_info{ stops[stop] };
-			stop_info.bus_list.insert(id);
-			++stop_info.navigation.bus_passes_count;
+	constexpr BusId no_bus{ numeric_limits<BusId>::max() };
+	const size_t stop_count{ stops.Size() };
+	stops.bus_passes.assign(stop_count, 0);
+	buses.waybill_vertices.resize(buses.waybill_stops.size());
+
+	/*Buses are visited in alphabetical order, so the bus lists are sorted and duplicates are adjacent*/
+	vector<uint32_t> bus_counts(stop_count, 0);
+	vector<BusId> last_bus(stop_count, no_bus);
+	for (BusId bus = 0; bus < buses.Size(); ++bus) {
+		for (uint32_t pos = buses.waybill_bounds[bus].first; pos < buses.waybill_bounds[bus].second; ++pos) {
+			const StopId stop{ buses.waybill_stops[pos] };
+			buses.waybill_vertices[pos] = stops.bus_passes[stop]++;		//Pass number (initialize_vertices makes it a vertex)
+			if (last_bus[stop] != bus) {
+				last_bus[stop] = bus;
+				++bus_counts[stop];
+			}
+		}
+	}
+
+	stops.bus_bounds.resize(stop_count);
+	uint32_t offset{ 0 };
+	for (size_t stop = 0; stop < stop_count; ++stop) {
+		stops.bus_bounds[stop] = { offset, offset };
+		offset += bus_counts[stop];
+	}
+	stops.bus_names.resize(offset);
+	fill(last_bus.begin(), last_bus.end(), no_bus);
+	for (BusId bus = 0; bus < buses.Size(); ++bus) {
+		for (const auto stop : buses.GetWaybill(bus)) {
+			if (last_bus[stop] != bus) {
+				last_bus[stop] = bus;
+				stops.bus_names[stops.bus_bounds[stop].second++] = buses.names[bus];
+			}
 		}
 	}
 }
 
-size_t TransportCatalog::initialize_root_vertex_index(StopsDatabase* stops_base) noexcept {
+size_t TransportCatalog::initialize_vertices() {
 	VertexId current_root{ 0 };
-	for (auto& [stop_id, stop_info] : *stops_base) {
-		stop_info.navigation.root_vertex_id = current_root;
-		current_root += stop_info.navigation.bus_passes_count + 1;					//Root vertex and one vertex for each bus
+	stops.root_vertices.resize(stops.Size());
+	for (StopId stop = 0; stop < stops.Size(); ++stop) {
+		stops.root_vertices[stop] = current_root;
+		current_root += stops.bus_passes[stop] + 1;					//Root vertex and one vertex for each bus
 	}
-	return current_root;
-}
 
-void TransportCatalog::calculate_all_routes_stats() {
-	for (auto& [bus_id, bus_info] : buses) {
-		bus_info.stats = calculate_single_route_stats(bus_info.waybill, bus_info.is_roundtrip);
+	/*The bus vertices of a stop follow its root vertex in the order of passes*/
+	for (size_t pos = 0; pos < buses.waybill_stops.size(); ++pos) {
+		buses.waybill_vertices[pos] += stops.root_vertices[buses.waybill_stops[pos]] + 1;
 	}
+	return current_root;
 }
 
 #ifdef MULTITHREADING
+algo::execution::Task<void> TransportCatalog::calculate_all_routes_stats() {
+	const StageTimer timer{ sync_timings[ROUTE_STATS] };
+	co_await for_each_id<BusId>(buses.Size(), [this](BusId bus) {
+		buses.stats[bus] = calculate_single_route_stats(bus);
+		});
+}
+
 /*NOT synchronized*/
-optional<Route> TransportCatalog::get_bus_route_stats(BusIt bus) const {
-	return bus->second.stats;
+optional<Route> TransportCatalog::get_bus_route_stats(BusId bus) const {
+	return buses.stats[bus];
 }
 #else	/*Lazy calculation*/
-optional<Route> TransportCatalog::get_bus_route_stats(BusIt bus) const {
-	auto& bus_info{ bus->second };
-	if (!bus_info.stats) {
-		bus_info.stats = calculate_single_route_stats(bus_info.waybill, bus_info.is_roundtrip);
+optional<Route> TransportCatalog::get_bus_route_stats(BusId bus) const {
+	auto& bus_stats{ buses.stats[bus] };
+	if (!bus_stats) {
+		bus_stats = calculate_single_route_stats(bus);
 	}
-	return bus_info.stats;
+	return bus_stats;
 }
 #endif
 
 
-Route TransportCatalog::calculate_single_route_stats(const Waybill& waybill, bool is_roundtrip) const {
+Route TransportCatalog::calculate_single_route_stats(BusId bus) const {
 	Route route;
-	unordered_set<string_view> unique_stops_counter;
-
-	for (auto stop_it = waybill.begin(); stop_it != waybill.end(); ++route.stops, ++stop_it) {
-		auto stop_data_it{ stops.find(*stop_it) };										//Iterator to the first stop
-		unique_stops_counter.insert(*stop_it);
+	const Waybill waybill{ buses.GetWaybill(bus) };
+	const bool is_roundtrip{ buses.is_roundtrip[bus] };
+	const uint32_t first{ buses.waybill_bounds[bus].first };
 
-		auto next_stop_it = next(stop_it);
-		if (next_stop_it != waybill.end()) {
-			auto next_stop_data_it{ stops.find(*next_stop_it) };						//Iterator to the second stop
-			route.distance += calc_distance(*stop_data_it, *next_stop_data_it);
+	for (size_t idx = 0; idx < waybill.size(); ++route.stops, ++idx) {
+		if (idx + 1 < waybill.size()) {
+			route.distance += buses.forward_segments[first + idx];
 			if (!is_roundtrip) {														//Roundtrip  = circle route
-				route.distance += calc_distance(*next_stop_data_it, *stop_data_it);		//The distance when the bus moves back may be different
+				route.distance += buses.backward_segments[first + idx];					//The distance when the bus moves back may be different
 			}
 		}
 	}
 
-	route.unique_stops = unique_stops_counter.size();
+	vector<StopId> unique_stops(waybill.begin(), waybill.end());
+	sort(unique_stops.begin(), unique_stops.end());
+	route.unique_stops = static_cast<size_t>(distance(
+		unique_stops.begin(),
+		unique(unique_stops.begin(), unique_stops.end())
+	));
 	if (!is_roundtrip) {
 		(route.stops <<= 1) -= 1;														 //If route isn't roundtrip final stop isn't unique
 	}
 	else {
 		++route.stops;
-		auto final_it{ stops.find(waybill.front()) };
-		auto previous_it{ stops.find(waybill.back()) };
-		route.distance += calc_distance(*previous_it, *final_it);
+		route.distance += buses.forward_segments[first + waybill.size() - 1];
 	}
 
 	return route;
 }
 
-TransportCatalog::TransportGraphHolder TransportCatalog::make_graph(size_t vertex_count) {
-	using routing::Point;
-	TransportGraphHolder graph_holder(make_unique<TransportGraph>(vertex_count));
-	unordered_map<string_view, size_t> current_vertex;
-
-	add_transitional_stops(graph_holder.get());
-
-	for (const auto& [bus_id, bus_info] : buses) {
-		const auto& waybill{ bus_info.waybill };
-
-		for (auto stop_it = waybill.begin(); stop_it != waybill.end(); ++stop_it) {
-			auto stop_data_it{ stops.find(*stop_it) };
-			const VertexId first_root_vertex{ *stop_data_it->second.navigation.root_vertex_id };	//No value check required
-
-			auto next_stop_it = next(stop_it);
-			if (next_stop_it != waybill.end()) {
-				auto next_stop_data_it{ stops.find(*next_stop_it) };						
-				const VertexId second_root_vertex{ *next_stop_data_it->second.navigation.root_vertex_id },
-					first_bus_vertex{ first_root_vertex + current_vertex[*stop_it] + 1 },
-					second_bus_vertex{ second_root_vertex + current_vertex[*next_stop_it] + 1 };
-
-				add_route_edges(
-					graph_holder.get(),
-
-					/*Connect two bus vertexex with edge*/
-					pair{ first_bus_vertex, second_bus_vertex },
-
-					calc_distance(*stop_data_it, *next_stop_data_it).real,
-					bus_id
-				);
-
-				if (!bus_info.is_roundtrip) {
-					add_route_edges(
-						graph_holder.get(),
-
-						/*If the stop is final, connect the edge to the root vertex*/
-						pair{ second_bus_vertex, stop_it != waybill.begin() ? first_bus_vertex : first_root_vertex },
-
-						calc_distance(*next_stop_data_it, *stop_data_it).real,
-						bus_id
-					);
-				}		
-			}
-			++current_vertex[*stop_it];
+TransportCatalog::TransportGraphHolder TransportCatalog::make_graph(
+	size_t vertex_count, 
+	const vector<vector<Edge>>& route_edges
+) const {
+	TransportGraphBuilder builder(vertex_count);
+	add_transitional_stops(&builder);
+	for (const auto& edges : route_edges) {									//Edges are added in the bus order
+		for (const auto& edge : edges) {
+			builder.AddEdge(edge);
 		}
+	}
+	return make_unique<TransportGraph>(builder);							//The builder isn't kept
+}
 
-		if (bus_info.is_roundtrip) {
-			auto final_it{ stops.find(bus_info.waybill.front()) };
-			auto previous_it{ stops.find(bus_info.waybill.back()) };
-			add_route_edges(
-				graph_holder.get(),
-
-				/*Connect penultimate and final stops*/
-				pair{ 
-					*previous_it->second.navigation.root_vertex_id 
-				+ current_vertex.at(
-					bus_info.waybill.back()
-				), 
-				*final_it->second.navigation.root_vertex_id 
-				},
-
-				calc_distance(*previous_it, *final_it).real,
-				bus_id
-			);
+vector<TransportCatalog::Edge> TransportCatalog::make_route_edges(BusId bus) const {
+	vector<Edge> edges;
+	const Waybill waybill{ buses.GetWaybill(bus) };
+	const string_view bus_name{ buses.names[bus] };
+	const bool is_roundtrip{ buses.is_roundtrip[bus] };
+	const auto bus_vertices{ span(buses.waybill_vertices).subspan(buses.waybill_bounds[bus].first, waybill.size()) };
+	const auto forward_segments{ span(buses.forward_segments).subspan(buses.waybill_bounds[bus].first, waybill.size()) },
+		backward_segments{ span(buses.backward_segments).subspan(buses.waybill_bounds[bus].first, waybill.size()) };
+	edges.reserve(is_roundtrip ? waybill.size() : 2 * waybill.size());
+
+	for (size_t idx = 0; idx + 1 < waybill.size(); ++idx) {
+		const VertexId first_bus_vertex{ bus_vertices[idx] },
+			second_bus_vertex{ bus_vertices[idx + 1] };
+
+		edges.push_back(make_route_edge(
+			/*Connect two bus vertexex with edge*/
+			pair{ first_bus_vertex, second_bus_vertex },
+			forward_segments[idx].real,
+			bus_name
+		));
+
+		if (!is_roundtrip) {
+			edges.push_back(make_route_edge(
+				/*If the stop is final, connect the edge to the root vertex*/
+				pair{ second_bus_vertex, idx != 0 ? first_bus_vertex : stops.root_vertices[waybill[idx]] },
+				backward_segments[idx].real,
+				bus_name
+			));
 		}
-	} 
-	return graph_holder;
+	}
+
+	if (is_roundtrip) {
+		edges.push_back(make_route_edge(
+			/*Connect penultimate and final stops*/
+			pair{ 
+				bus_vertices.back(),
+				stops.root_vertices[waybill.front()]
+			},
+			forward_segments.back().real,
+			bus_name
+		));
+	}
+	return edges;
 }
 
-void TransportCatalog::add_route_edges(
-	TransportGraph* graph,
+TransportCatalog::Edge TransportCatalog::make_route_edge(
 	pair<VertexId, VertexId> from_to,
 	double distance,
 	std::string_view bus_name
-) {
+) const {
 	using routing::Point;
 
-	graph->AddEdge(Edge{
-				from_to.first,
-				from_to.second,
-				geographic::travel_time(
-					distance,
-					geographic::kmph_to_mpmin(routing_settings->bus_velocity)
-				),
-				EdgeData{ Point::Type::BUS, bus_name }
-		});
+	return Edge{
+		from_to.first,
+		from_to.second,
+		geographic::travel_time(
+			distance,
+			geographic::kmph_to_mpmin(routing_settings->bus_velocity)
+		),
+		EdgeData{ Point::Type::BUS, bus_name }
+	};
 }
 
 
-void TransportCatalog::add_transitional_stops(TransportGraph* graph) {	//One stop for each route
-	for (const auto& [stop_id, stop_info] : stops) {
-		const VertexId root_vertex{ *stop_info.navigation.root_vertex_id };
-		for (size_t i = 0; i < stop_info.navigation.bus_passes_count; ++i) {
+void TransportCatalog::add_transitional_stops(TransportGraphBuilder* graph) const {	//One stop for each route
+	for (StopId stop = 0; stop < stops.Size(); ++stop) {
+		const VertexId root_vertex{ stops.root_vertices[stop] };
+		for (size_t i = 0; i < stops.bus_passes[stop]; ++i) {
 			connect_transitional_stops(
 				graph,
 				pair{ root_vertex, root_vertex + i + 1 },
 				static_cast<double>(routing_settings->bus_wait_time),
-				stop_id
+				stops.names[stop]
 			);
 		}
 	}
 }
 
 void TransportCatalog::connect_transitional_stops(	//Connect root vertex to all route vertices for each stop using pair of edges
-	TransportGraph* graph,
+	TransportGraphBuilder* graph,
 	std::pair<size_t, size_t> stop_vertex,
 	double wait_time,
 	string_view stop_name
@@ -328,13 +755,17 @@ optional<routing::OnMap> TransportCatalog::GetRouting(const routing::Bounds& seg
 	using routing::OnMap;
 
 
-	const auto& first_stop{ stops.at(segment.from) },
-		last_stop{ stops.at(segment.to) };
+	const StopId first_stop{ get_stop(segment.from) },
+		last_stop{ get_stop(segment.to) };
 
-	auto routing{ navigator->BuildRoute(
-		*first_stop.navigation.root_vertex_id,
-		*last_stop.navigation.root_vertex_id)
-	};
+	flush_graph_changes();												//The deltas since the last search
+	const VertexId from{ stops.root_vertices[first_stop] },
+		to{ stops.root_vertices[last_stop] };
+	if (components.IsUnreachable(from, to)) {							//No search for the disconnected stops
+		return nullopt;
+	}
+
+	auto routing{ navigator->BuildRoute(from, to) };
 
 	if (!routing) {
 		return nullopt;
@@ -350,10 +781,11 @@ routing::OnMap TransportCatalog::collect_route_points(const TransportGraphRoute&
 	double total_time{ 0 };
 
 	for (const auto& edge_id : graph_route) {
-		const auto& edge{ graph->GetEdge(edge_id)};
+		const auto& item{ graph->GetData(edge_id) };
+		const Weight weight{ graph->GetWeight(edge_id) };
 
-		if (edge.item) {
-			Point point{ make_routing_point(edge) };
+		if (item) {
+			Point point{ make_routing_point(*item, weight) };
 
 			if (route.empty() ||									//Insert new point
 				route.back().type == Point::Type::WAIT ||
@@ -366,7 +798,7 @@ routing::OnMap TransportCatalog::collect_route_points(const TransportGraphRoute&
 				++*route.back().span_count;							//Update last point
 				route.back().time += point.time;
 			}
-			total_time += edge.weight;
+			total_time += weight;
 		}	
 	}
 	return OnMap{
@@ -375,15 +807,15 @@ routing::OnMap TransportCatalog::collect_route_points(const TransportGraphRoute&
 	};
 }
 
-routing::Point TransportCatalog::make_routing_point(const TransportCatalog::Edge& edge) noexcept {
+routing::Point TransportCatalog::make_routing_point(const EdgeData& item, Weight weight) noexcept {
 	using routing::Point;
 
-	const bool waiting{ edge.item->type == Point::Type::WAIT };
+	const bool waiting{ item.type == Point::Type::WAIT };
 
 	return routing::Point{
-		edge.item->type,
-		edge.item->name,
-		edge.weight,
+		item.type,
+		item.name,
+		weight,
 		waiting ? nullopt : optional<uint64_t>(1)
 	};
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "transport_catalog.h"
 #include "numbers_smart_comparison.h"
+
 using namespace std;
 
 #ifdef RENDER
@@ -15,12 +16,48 @@ const svg::Document& TransportCatalog::GetMap() const {
 svg::Document TransportCatalog::render_map() const {
 	svg::Document doc;
 	const auto& layer_sequence{ render_settings->layer_sequence };
-	for (const auto& layer : layer_sequence) {
-		layer_renderers.at(layer)(this, addressof(doc));
+	layer_cache.resize(layer_sequence.size());
+	for (size_t idx = 0; idx < layer_sequence.size(); ++idx) {
+		auto& layer{ layer_cache[idx] };
+		if (!layer) {															//Only the invalidated layers are drawn again
+			layer.emplace();
+			layer_renderers.at(layer_sequence[idx])(this, addressof(*layer));
+		}
+		doc.Merge(*layer);
 	}
 	return doc;
 }
 
+void TransportCatalog::invalidate_layers(initializer_list<string_view> layers) {
+	const auto& layer_sequence{ render_settings->layer_sequence };
+	for (size_t idx = 0; idx < layer_cache.size(); ++idx) {
+		if (find(layers.begin(), layers.end(), layer_sequence[idx]) != layers.end()) {
+			layer_cache[idx].reset();
+			render_cache.reset();
+		}
+	}
+}
+
+void TransportCatalog::update_map_layout(bool are_routes_changed) {
+	const auto previous_indices{ stops.map_indices };
+	const Step previous_step{ *step_info };
+
+	collect_route_neighbours();
+	stops.map_indices.assign(stops.Size(), MapIndex{});
+	const MapIndex max_idx{
+		.x_idx = distribute_stops_on_x_axis(),
+		.y_idx = distribute_stops_on_y_axis()
+	};
+	step_info = calculate_step_settings(max_idx);
+
+	if (previous_indices != stops.map_indices || previous_step != *step_info) {
+		invalidate_layers({ "bus_lines", "bus_labels", "stop_points", "stop_labels" });
+	}
+	else if (are_routes_changed) {
+		invalidate_layers({ "bus_lines", "bus_labels" });
+	}
+}
+
 unique_ptr<TransportCatalog::Step> TransportCatalog::calculate_step_settings(MapIndex max_index) const {
 	const auto& [width, height, padding]{ render_settings->map };
 	return make_unique<Step>(
@@ -31,44 +68,39 @@ unique_ptr<TransportCatalog::Step> TransportCatalog::calculate_step_settings(Map
 	);
 }
 
-vector<TransportCatalog::StopHandleIt> 
-TransportCatalog::collect_stops_location(StopsDatabase& stops) {
-	vector<StopHandleIt> stops_location;
-	stops_location.reserve(stops.size());
-	for (auto it = stops.begin(); it != stops.end(); ++it) {
-		stops_location.push_back(it);
-	}
-	return stops_location;
+vector<TransportCatalog::StopId> 
+TransportCatalog::collect_stops_location(const StopsTable& stops) {
+	return stops.by_name;
 }
 
-TransportCatalog::MapIndex TransportCatalog::distribute_stops_on_map() {
+size_t TransportCatalog::distribute_stops_on_x_axis() {
 	auto stops_location{ collect_stops_location(stops) };
-	MapIndex max_index;
-
 
 	/*longitude compression*/
 	compress_coordinates_in_place(
 		addressof(stops_location),
-		[](StopIt left, StopIt right) {
-			return left->second.coordinates.longitude < right->second.coordinates.longitude;
+		[this](StopId left, StopId right) {
+			return stops.coordinates[left].longitude < stops.coordinates[right].longitude;
 		},
 		[](MapIndex* idx, size_t new_value) {
 			idx->x_idx = new_value; 
 		});
-	max_index.x_idx = stops_location.empty() ? 0 : stops_location.back()->second.index_on_map.x_idx;
+	return stops_location.empty() ? 0 : stops.map_indices[stops_location.back()].x_idx;
+}
+
+size_t TransportCatalog::distribute_stops_on_y_axis() {
+	auto stops_location{ collect_stops_location(stops) };
 
 	/*latitude compression*/
 	compress_coordinates_in_place(
 		addressof(stops_location),
-		[](StopIt left, StopIt right) {
-			return left->second.coordinates.latitude < right->second.coordinates.latitude;
+		[this](StopId left, StopId right) {
+			return stops.coordinates[left].latitude < stops.coordinates[right].latitude;
 		},
 		[](MapIndex* idx, size_t new_value) {
 			idx->y_idx = new_value;
 		});
-	max_index.y_idx = stops_location.empty() ? 0 : stops_location.back()->second.index_on_map.y_idx;
-
-	return max_index;
+	return stops_location.empty() ? 0 : stops.map_indices[stops_location.back()].y_idx;
 }
 
 svg::Point TransportCatalog::scale_coordinates(MapIndex idx) const noexcept {
@@ -93,14 +125,14 @@ function<const Color&()> TransportCatalog::get_color_selector() const noexcept {
 }
 
 void TransportCatalog::print_stops(svg::Document* doc) const {
-	for (const auto& [_, stop_info] : stops) {
-		draw_stop(doc, stop_info);
+	for (const auto stop : stops.by_name) {
+		draw_stop(doc, stop);
 	}
 }
 
 void TransportCatalog::print_stop_labels(svg::Document* doc) const {
-	for (const auto& [stop_id, stop_info] : stops) {
-		draw_stop_label(doc, stop_id, stop_info);
+	for (const auto stop : stops.by_name) {
+		draw_stop_label(doc, stop);
 	}
 }
 
@@ -108,8 +140,8 @@ void TransportCatalog::print_bus_labels(svg::Document* doc) const {
 	/*Color selection*/
 	auto color_selector{ get_color_selector() };
 
-	for (const auto& [bus_id, bus_info] : buses) {
-		draw_bus_label(doc, bus_id, bus_info, color_selector());
+	for (const auto bus : buses.by_name) {
+		draw_bus_label(doc, bus, color_selector());
 	}
 }
 
@@ -117,33 +149,33 @@ void TransportCatalog::print_bus_routes(svg::Document* doc) const {
 	/*Color selection*/
 	auto color_selector{ get_color_selector()};
 
-	for (const auto& [_, bus_info] : buses) {
-		draw_route(doc, bus_info, color_selector());
+	for (const auto bus : buses.by_name) {
+		draw_route(doc, bus, color_selector());
 	}
 }
 
-void TransportCatalog::draw_stop(svg::Document* doc, const StopHolder& stop) const {
+void TransportCatalog::draw_stop(svg::Document* doc, StopId stop) const {
 	doc->Add(
 		svg::Circle{}
 		.SetCenter(
-			scale_coordinates(stop.index_on_map)
+			scale_coordinates(stops.map_indices[stop])
 		)
 		.SetRadius(render_settings->route.stop_radius)
 		.SetFillColor("white")
 	);
 }
 
-void TransportCatalog::draw_stop_label(svg::Document* doc, StopId stop_id, const StopHolder& stop_info) const {
+void TransportCatalog::draw_stop_label(svg::Document* doc, StopId stop) const {
 	emplace_stop_label_on_map(
 		doc,
-		stop_id,
-		scale_coordinates(stop_info.index_on_map)
+		stops.names[stop],
+		scale_coordinates(stops.map_indices[stop])
 	);
 }
 
 void TransportCatalog::emplace_stop_label_on_map(
 	svg::Document* doc,
-	StopId stop_id,
+	string_view stop_name,
 	svg::Point point
 )  const {
 	const auto& label_settings{ render_settings->stop_label };
@@ -155,7 +187,7 @@ void TransportCatalog::emplace_stop_label_on_map(
 		.SetOffset(label_settings.offset)
 		.SetFontSize(label_settings.font_size)
 		.SetFontFamily("Verdana")
-		.SetData(string(stop_id));	//StopId - string_view!
+		.SetData(string(stop_name));
 
 	doc->Add(	//Substrate
 		svg::Text(label_base)
@@ -174,26 +206,25 @@ void TransportCatalog::emplace_stop_label_on_map(
 
 void TransportCatalog::draw_bus_label(
 	svg::Document* doc, 
-	BusId bus_id, 
-	const BusHolder& bus_info, 
+	BusId bus, 
 	const Color& color
 ) const {
-	const auto& waybill{ bus_info.waybill };
+	const Waybill waybill{ buses.GetWaybill(bus) };
 	if (!waybill.empty()) {
-		const auto& final_stop_indices{ stops.at(waybill.front()).index_on_map };
+		const auto& final_stop_indices{ stops.map_indices[waybill.front()] };
 		emplace_bus_label_on_map(
 			doc,
-			bus_id,
+			buses.names[bus],
 			scale_coordinates(final_stop_indices),
 			color
 		);
 	}
 	/*The bus can repeatedly pass through the final stop*/
-	if (!bus_info.is_roundtrip && waybill.back() != waybill.front()) {
-		const auto& further_stop_indices{ stops.at(waybill.back()).index_on_map };
+	if (!buses.is_roundtrip[bus] && waybill.back() != waybill.front()) {
+		const auto& further_stop_indices{ stops.map_indices[waybill.back()] };
 		emplace_bus_label_on_map(
 			doc,
-			bus_id,
+			buses.names[bus],
 			scale_coordinates(further_stop_indices),
 			color
 		);
@@ -202,7 +233,7 @@ void TransportCatalog::draw_bus_label(
 
 void TransportCatalog::emplace_bus_label_on_map(
 	svg::Document* doc,
-	BusId bus_id,
+	string_view bus_name,
 	svg::Point point,
 	const svg::Color& color
 )  const {
@@ -216,7 +247,7 @@ void TransportCatalog::emplace_bus_label_on_map(
 		.SetFontSize(label_settings.font_size)
 		.SetFontFamily("Verdana")
 		.SetFontWeight("bold")
-		.SetData(string(bus_id));	//BusId - string_view!
+		.SetData(string(bus_name));
 
 	doc->Add(
 		svg::Text(label_base)
@@ -232,49 +263,54 @@ void TransportCatalog::emplace_bus_label_on_map(
 	);
 }
 
-void TransportCatalog::draw_route(svg::Document* doc, const BusHolder& bus, const Color& color) const {
+void TransportCatalog::draw_route(svg::Document* doc, BusId bus, const Color& color) const {
 	svg::Polyline route_polyline;
 	route_polyline
 		.SetStrokeLineCap("round")
 		.SetStrokeLineJoin("round")
 		.SetStrokeColor(color)
 		.SetStrokeWidth(render_settings->route.line_width);
-	const auto& waybill{ bus.waybill };
+	const Waybill waybill{ buses.GetWaybill(bus) };
 
 	route_polyline.MergePoints(create_route_polyline(waybill.begin(), waybill.end(), color));
 	if (!waybill.empty()) {
-		if (!bus.is_roundtrip) {	/*Return trip*/
+		if (!buses.is_roundtrip[bus]) {	/*Return trip*/
 			route_polyline.MergePoints(create_route_polyline(next(waybill.rbegin()), waybill.rend(), color));
 		}
 		else { /*Connect final and pre-final stops*/
-			const svg::Point final_stop_on_map{ scale_coordinates(stops.at(waybill.front()).index_on_map) };
+			const svg::Point final_stop_on_map{ scale_coordinates(stops.map_indices[waybill.front()]) };
 			route_polyline.AddPoint(final_stop_on_map);
 		}
 	}
 	doc->Add(move(route_polyline));
 }
 
-bool TransportCatalog::are_neighbors_on_route(StopIt from, StopIt to) const {
-	const auto& [from_vertex_id, from_bus_passes_count] {from->second.navigation};
-	const auto& [to_vertex_id, to_bus_passes_count] { to->second.navigation };
+namespace {
+	uint64_t make_neighbours_key(uint32_t left, uint32_t right) noexcept {
+		return static_cast<uint64_t>(min(left, right)) << 32 | max(left, right);
+	}
+}
 
-	for (size_t from_idx = 1; from_idx <= from_bus_passes_count; ++from_idx) {							//The route can only start from the transitional vertex
-		for (size_t to_idx = 0; to_idx <= to_bus_passes_count; ++to_idx) {								//But it can also end in root vertex
-			if (graph->HasEdge(from_vertex_id.value() + from_idx, to_vertex_id.value() + to_idx)) {
-				return true;
-			}
-		}	
+void TransportCatalog::collect_route_neighbours() {
+	route_neighbours.clear();
+	for (const auto bus : buses.by_name) {
+		const Waybill waybill{ buses.GetWaybill(bus) };
+		for (size_t idx = 0; idx + 1 < waybill.size(); ++idx) {
+			route_neighbours.insert(make_neighbours_key(waybill[idx], waybill[idx + 1]));
+		}
+		if (buses.is_roundtrip[bus] && !waybill.empty()) {					//Final and pre-final stops
+			route_neighbours.insert(make_neighbours_key(waybill.back(), waybill.front()));
+		}
 	}
-	return false;
 }
 
-bool TransportCatalog::can_be_compressed(StopIt left_id, StopIt right_id) const {
-	return !are_neighbors_on_route(left_id, right_id) && !are_neighbors_on_route(right_id, left_id);
+bool TransportCatalog::can_be_compressed(StopId left_id, StopId right_id) const {
+	return !route_neighbours.contains(make_neighbours_key(left_id, right_id));
 }
 
 void TransportCatalog::compress_coordinates_in_place(
-	std::vector<StopHandleIt>* storage,
-	std::function<bool(StopIt left, StopIt right)> pred,
+	std::vector<StopId>* storage,
+	std::function<bool(StopId left, StopId right)> pred,
 	std::function<void(MapIndex*, size_t)> visitor
 ) {
 	sort(storage->begin(), storage->end(), pred);
@@ -286,7 +322,7 @@ void TransportCatalog::compress_coordinates_in_place(
 				find_if_not(
 						base_it,
 						compress_it,
-						[this, &compress_it](StopIt current_stop_it) {
+						[this, &compress_it](StopId current_stop_it) {
 						return can_be_compressed(*compress_it,  current_stop_it);
 					}
 				)
@@ -295,7 +331,7 @@ void TransportCatalog::compress_coordinates_in_place(
 				base_it = compress_it;
 				++idx;
 			}
-			visitor(addressof((*compress_it)->second.index_on_map), idx);
+			visitor(addressof(stops.map_indices[*compress_it]), idx);
 		}
 	}	
 }
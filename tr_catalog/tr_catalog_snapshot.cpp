@@ -0,0 +1,405 @@
+#include "transport_catalog.h"
+
+using stats::Route;
+using namespace std;
+
+namespace {
+	void expect(bool condition) {
+		if (!condition) {
+			throw invalid_argument("Snapshot: sections don't match each other");
+		}
+	}
+
+	/*Checked range of a CSR array*/
+	template <class Record>
+	span<const Record> get_slice(span<const Record> records, snapshot::Bounds bounds) {
+		expect(bounds.first <= bounds.last && bounds.last <= records.size());
+		return records.subspan(bounds.first, bounds.last - bounds.first);
+	}
+}
+
+void TransportCatalog::SaveSnapshot(const string& path) const {
+	if (!navigator) {
+		throw logic_error("Only a synchronized catalog can be saved");
+	}
+	flush_graph_changes();
+	snapshot::Writer writer;
+	writer.SetSection(snapshot::ROUTING_SETTINGS, vector{
+		snapshot::RoutingSettings{ routing_settings->bus_wait_time, routing_settings->bus_velocity }
+		});
+	save_stops(addressof(writer));
+	save_buses(addressof(writer));
+	save_graph(addressof(writer));
+	save_pending_distances(addressof(writer));
+
+	uint32_t flags{ 0 };
+#ifdef RENDER
+	flags |= snapshot::MAP_LAYOUT;
+#endif
+	writer.Save(path, flags);
+}
+
+void TransportCatalog::save_stops(snapshot::Writer* writer) const {
+	const size_t stop_count{ stops.Size() };
+	vector<snapshot::StringRef> names;
+	vector<snapshot::Coordinates> coordinates;
+	vector<snapshot::Bounds> distance_bounds, bus_list_bounds;
+	vector<snapshot::RoadDistance> road_distances;
+	vector<uint32_t> root_vertices, bus_lists;
+	names.reserve(stop_count);
+	coordinates.reserve(stop_count);
+	distance_bounds.reserve(stop_count);
+	bus_list_bounds.reserve(stop_count);
+	root_vertices.reserve(stop_count);
+
+	for (StopId stop = 0; stop < stop_count; ++stop) {
+		names.push_back(writer->AddString(stops.names[stop]));
+		coordinates.push_back({ stops.coordinates[stop].latitude, stops.coordinates[stop].longitude });
+		root_vertices.push_back(static_cast<uint32_t>(stops.root_vertices[stop]));
+
+		const auto first_distance{ static_cast<uint32_t>(road_distances.size()) };
+		for (const auto& [neighbour, distance] : stops.GetRoadDistances(stop)) {
+			road_distances.push_back({ distance, neighbour, 0 });
+		}
+		distance_bounds.push_back({ first_distance, static_cast<uint32_t>(road_distances.size()) });
+
+		/*Bus lists are saved compacted, as bus ids*/
+		const auto first_bus{ static_cast<uint32_t>(bus_lists.size()) };
+		for (const auto bus_name : stops.GetBusList(stop)) {
+			bus_lists.push_back(*find_bus(bus_name));
+		}
+		bus_list_bounds.push_back({ first_bus, static_cast<uint32_t>(bus_lists.size()) });
+	}
+
+	writer->SetSection(snapshot::STOP_NAMES, names);
+	writer->SetSection(snapshot::STOP_ORDER, stops.by_name);
+	writer->SetSection(snapshot::STOP_COORDINATES, coordinates);
+	writer->SetSection(snapshot::ROAD_DISTANCE_BOUNDS, distance_bounds);
+	writer->SetSection(snapshot::ROAD_DISTANCES, road_distances);
+	writer->SetSection(snapshot::ROOT_VERTICES, root_vertices);
+	writer->SetSection(snapshot::BUS_PASSES, stops.bus_passes);
+	writer->SetSection(snapshot::BUS_LIST_BOUNDS, bus_list_bounds);
+	writer->SetSection(snapshot::BUS_LISTS, bus_lists);
+#ifdef RENDER
+	vector<snapshot::MapIndex> map_indices;
+	map_indices.reserve(stop_count);
+	for (const auto& [x_idx, y_idx] : stops.map_indices) {
+		map_indices.push_back({ x_idx, y_idx });
+	}
+	writer->SetSection(snapshot::MAP_INDICES, map_indices);
+#endif
+}
+
+void TransportCatalog::save_buses(snapshot::Writer* writer) const {
+	const size_t bus_count{ buses.Size() };
+	vector<snapshot::StringRef> names;
+	vector<uint8_t> flags;
+	vector<snapshot::Bounds> waybill_bounds;
+	vector<StopId> waybill_stops;
+	vector<uint32_t> waybill_vertices;
+	vector<snapshot::RouteStats> route_stats;
+	names.reserve(bus_count);
+	flags.reserve(bus_count);
+	waybill_bounds.reserve(bus_count);
+	route_stats.reserve(bus_count);
+
+	for (BusId bus = 0; bus < bus_count; ++bus) {
+		names.push_back(writer->AddString(buses.names[bus]));
+		flags.push_back(
+			(buses.is_roundtrip[bus] ? snapshot::ROUNDTRIP : 0)
+			| (buses.is_active[bus] ? snapshot::ACTIVE : 0)
+		);
+
+		/*Waybills are saved compacted*/
+		const auto [first, last] { buses.waybill_bounds[bus] };
+		waybill_bounds.push_back({ static_cast<uint32_t>(waybill_stops.size()), static_cast<uint32_t>(waybill_stops.size() + last - first) });
+		for (uint32_t pos = first; pos < last; ++pos) {
+			waybill_stops.push_back(buses.waybill_stops[pos]);
+			waybill_vertices.push_back(static_cast<uint32_t>(buses.waybill_vertices[pos]));
+		}
+
+		snapshot::RouteStats bus_stats{};
+		if (buses.is_active[bus]) {
+			const Route route{ *get_bus_route_stats(bus) };					//Lazy stats are calculated now
+			bus_stats = { route.stops, route.unique_stops, route.distance.geographic, route.distance.real };
+		}
+		route_stats.push_back(bus_stats);
+	}
+
+	writer->SetSection(snapshot::BUS_NAMES, names);
+	writer->SetSection(snapshot::BUS_ORDER, buses.by_name);
+	writer->SetSection(snapshot::BUS_FLAGS, flags);
+	writer->SetSection(snapshot::WAYBILL_BOUNDS, waybill_bounds);
+	writer->SetSection(snapshot::WAYBILL_STOPS, waybill_stops);
+	writer->SetSection(snapshot::WAYBILL_VERTICES, waybill_vertices);
+	writer->SetSection(snapshot::ROUTE_STATS, route_stats);
+}
+
+void TransportCatalog::save_graph(snapshot::Writer* writer) const {
+	using routing::Point;
+
+	/*The CSR arrays are saved as is, edge data refers to the stop or the bus by id*/
+	const auto items{ graph->GetItems() };
+	vector<snapshot::EdgePayload> payloads;
+	payloads.reserve(items.size());
+	for (const auto& item : items) {
+		if (!item) {
+			payloads.push_back({ snapshot::EdgeKind::TRANSFER, 0 });
+		}
+		else if (item->type == Point::Type::WAIT) {
+			payloads.push_back({ snapshot::EdgeKind::WAIT, *find_stop(item->name) });
+		}
+		else {
+			payloads.push_back({ snapshot::EdgeKind::BUS, *find_bus(item->name) });
+		}
+	}
+
+	const auto offsets{ graph->GetOffsets() },
+		targets{ graph->GetTargets() };
+	const auto weights{ graph->GetWeights() };
+	writer->SetSection(snapshot::GRAPH_OFFSETS, vector<uint32_t>(offsets.begin(), offsets.end()));
+	writer->SetSection(snapshot::GRAPH_TARGETS, vector<uint32_t>(targets.begin(), targets.end()));
+	writer->SetSection(snapshot::GRAPH_WEIGHTS, vector<double>(weights.begin(), weights.end()));
+	writer->SetSection(snapshot::GRAPH_PAYLOADS, payloads);
+}
+
+void TransportCatalog::save_pending_distances(snapshot::Writer* writer) const {
+	vector<snapshot::PendingDistance> pending_distances;
+	for (const auto& [stop_name, distances] : pending_road_distances) {
+		const snapshot::StringRef name{ writer->AddString(stop_name) };
+		for (const auto& [from, distance] : distances) {
+			pending_distances.push_back({ name, distance, from, 0 });
+		}
+	}
+	writer->SetSection(snapshot::PENDING_DISTANCES, pending_distances);
+}
+
+void TransportCatalog::LoadSnapshot(const string& path) {
+	auto reader{ snapshot::Reader::Open(path) };
+	BusesTable loaded_buses{ load_buses(*reader) };
+	StopsTable loaded_stops{ load_stops(*reader, loaded_buses) };
+	TransportGraphHolder loaded_graph{ load_graph(*reader, loaded_stops, loaded_buses) };
+	auto loaded_pending_distances{ load_pending_distances(*reader, loaded_stops.Size()) };
+	const auto settings{ reader->View<snapshot::RoutingSettings>(snapshot::ROUTING_SETTINGS, 1).front() };
+	NameIndex<StopId> loaded_stop_ids(loaded_stops.names);
+	NameIndex<BusId> loaded_bus_ids(loaded_buses.names);
+
+	/*The file is valid: the catalog is replaced (the staged requests are dropped)*/
+	take_staged();
+	stops = move(loaded_stops);
+	buses = move(loaded_buses);
+	stop_ids = move(loaded_stop_ids);
+	bus_ids = move(loaded_bus_ids);
+	added_stop_ids.clear();
+	added_bus_ids.clear();
+	pending_road_distances = move(loaded_pending_distances);
+	index_pending_distances();
+	reset_revisions();
+
+	routing_settings = make_unique<routing::Parameters>(routing::Parameters{ settings.bus_wait_time, settings.bus_velocity });
+	measure_all_segments();												//Segments aren't saved: they are measured again
+	graph = move(loaded_graph);
+	reset_delta_state();
+
+	/*The waybills of the removed buses and the unused vertices are saved as is*/
+	for (BusId bus = 0; bus < buses.Size(); ++bus) {
+		if (!buses.is_active[bus]) {
+			garbage.waybill_items += buses.GetWaybill(bus).size();
+		}
+	}
+	const size_t used_vertices{ stops.Size() + buses.waybill_stops.size() - garbage.waybill_items };
+	garbage.vertices = graph->GetVertexCount() - min(graph->GetVertexCount(), used_vertices);
+	navigator = make_unique<Navigator>(*graph);
+	components = Graph::Components(*graph);
+	snapshot_file = move(reader);
+#ifdef RENDER
+	load_map_layout();
+#endif
+}
+
+TransportCatalog::BusesTable TransportCatalog::load_buses(const snapshot::Reader& reader) const {
+	BusesTable loaded;
+	const auto names{ reader.View<snapshot::StringRef>(snapshot::BUS_NAMES) };
+	const size_t bus_count{ names.size() };
+	loaded.names.reserve(bus_count);
+	for (const auto name : names) {
+		loaded.names.push_back(reader.GetString(name));
+	}
+
+	const auto by_name{ reader.View<BusId>(snapshot::BUS_ORDER) };
+	const auto flags{ reader.View<uint8_t>(snapshot::BUS_FLAGS, bus_count) };
+	const auto waybill_bounds{ reader.View<snapshot::Bounds>(snapshot::WAYBILL_BOUNDS, bus_count) };
+	const auto waybill_stops{ reader.View<StopId>(snapshot::WAYBILL_STOPS) };
+	const auto waybill_vertices{ reader.View<uint32_t>(snapshot::WAYBILL_VERTICES, waybill_stops.size()) };
+	const auto route_stats{ reader.View<snapshot::RouteStats>(snapshot::ROUTE_STATS, bus_count) };
+
+	loaded.by_name.assign(by_name.begin(), by_name.end());
+	loaded.waybill_stops.assign(waybill_stops.begin(), waybill_stops.end());
+	loaded.waybill_vertices.assign(waybill_vertices.begin(), waybill_vertices.end());
+	loaded.is_roundtrip.reserve(bus_count);
+	loaded.is_active.reserve(bus_count);
+	loaded.waybill_bounds.reserve(bus_count);
+	loaded.stats.reserve(bus_count);
+	for (BusId bus = 0; bus < bus_count; ++bus) {
+		const bool is_active{ (flags[bus] & snapshot::ACTIVE) != 0 };
+		loaded.is_roundtrip.push_back((flags[bus] & snapshot::ROUNDTRIP) != 0);
+		loaded.is_active.push_back(is_active);
+
+		const auto [first, last] { waybill_bounds[bus] };
+		get_slice(waybill_stops, waybill_bounds[bus]);
+		loaded.waybill_bounds.emplace_back(first, last);
+
+		const auto& bus_stats{ route_stats[bus] };
+		loaded.stats.push_back(is_active ?
+			optional<Route>(Route{ bus_stats.stops, bus_stats.unique_stops, { bus_stats.geographic, bus_stats.real } }) :
+			nullopt
+		);
+	}
+	for (const auto bus : loaded.by_name) {
+		expect(bus < bus_count && loaded.is_active[bus]);
+	}
+	return loaded;
+}
+
+TransportCatalog::StopsTable TransportCatalog::load_stops(const snapshot::Reader& reader, const BusesTable& loaded_buses) const {
+	StopsTable loaded;
+	const auto names{ reader.View<snapshot::StringRef>(snapshot::STOP_NAMES) };
+	const size_t stop_count{ names.size() };
+	loaded.names.reserve(stop_count);
+	for (const auto name : names) {
+		loaded.names.push_back(reader.GetString(name));
+	}
+
+	const auto by_name{ reader.View<StopId>(snapshot::STOP_ORDER, stop_count) };
+	const auto coordinates{ reader.View<snapshot::Coordinates>(snapshot::STOP_COORDINATES, stop_count) };
+	const auto distance_bounds{ reader.View<snapshot::Bounds>(snapshot::ROAD_DISTANCE_BOUNDS, stop_count) };
+	const auto road_distances{ reader.View<snapshot::RoadDistance>(snapshot::ROAD_DISTANCES) };
+	const auto root_vertices{ reader.View<uint32_t>(snapshot::ROOT_VERTICES, stop_count) };
+	const auto bus_passes{ reader.View<uint32_t>(snapshot::BUS_PASSES, stop_count) };
+	const auto bus_list_bounds{ reader.View<snapshot::Bounds>(snapshot::BUS_LIST_BOUNDS, stop_count) };
+	const auto bus_lists{ reader.View<BusId>(snapshot::BUS_LISTS) };
+
+	loaded.by_name.assign(by_name.begin(), by_name.end());
+	loaded.root_vertices.assign(root_vertices.begin(), root_vertices.end());
+	loaded.bus_passes.assign(bus_passes.begin(), bus_passes.end());
+	loaded.coordinates.reserve(stop_count);
+	loaded.distance_bounds.reserve(stop_count);
+	loaded.road_distances.reserve(road_distances.size());
+	loaded.bus_bounds.reserve(stop_count);
+	loaded.bus_names.reserve(bus_lists.size());
+	for (StopId stop = 0; stop < stop_count; ++stop) {
+		expect(by_name[stop] < stop_count);
+		loaded.coordinates.push_back({ coordinates[stop].latitude, coordinates[stop].longitude });
+
+		const auto first_distance{ static_cast<uint32_t>(loaded.road_distances.size()) };
+		for (const auto& [distance, neighbour, _] : get_slice(road_distances, distance_bounds[stop])) {
+			expect(neighbour < stop_count);
+			expect(loaded.road_distances.size() == first_distance || loaded.road_distances.back().first < neighbour);
+			loaded.road_distances.emplace_back(neighbour, distance);
+		}
+		loaded.distance_bounds.emplace_back(first_distance, static_cast<uint32_t>(loaded.road_distances.size()));
+
+		const auto first{ static_cast<uint32_t>(loaded.bus_names.size()) };
+		for (const auto bus : get_slice(bus_lists, bus_list_bounds[stop])) {
+			expect(bus < loaded_buses.Size());
+			loaded.bus_names.push_back(loaded_buses.names[bus]);
+		}
+		loaded.bus_bounds.emplace_back(first, static_cast<uint32_t>(loaded.bus_names.size()));
+	}
+	for (const auto stop : loaded_buses.waybill_stops) {
+		expect(stop < stop_count);
+	}
+	loaded.trig.Assign(loaded.coordinates);
+
+#ifdef RENDER
+	/*A snapshot saved without RENDER has no layout: it is laid out at load*/
+	if (reader.GetFlags() & snapshot::MAP_LAYOUT) {
+		const auto map_indices{ reader.View<snapshot::MapIndex>(snapshot::MAP_INDICES, stop_count) };
+		loaded.map_indices.reserve(stop_count);
+		for (const auto [x_idx, y_idx] : map_indices) {
+			loaded.map_indices.push_back({ x_idx, y_idx });
+		}
+	}
+#endif
+	return loaded;
+}
+
+TransportCatalog::TransportGraphHolder TransportCatalog::load_graph(
+	const snapshot::Reader& reader,
+	const StopsTable& loaded_stops,
+	const BusesTable& loaded_buses
+) const {
+	using routing::Point;
+	const auto offsets{ reader.View<uint32_t>(snapshot::GRAPH_OFFSETS) };
+	const auto targets{ reader.View<uint32_t>(snapshot::GRAPH_TARGETS) };
+	expect(!offsets.empty() && offsets.front() == 0 && offsets.back() == targets.size());
+	const size_t vertex_count{ offsets.size() - 1 };
+	const auto weights{ reader.View<double>(snapshot::GRAPH_WEIGHTS, targets.size()) };
+	const auto payloads{ reader.View<snapshot::EdgePayload>(snapshot::GRAPH_PAYLOADS, targets.size()) };
+
+	for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		expect(offsets[vertex] <= offsets[vertex + 1]);
+	}
+	for (const auto to : targets) {
+		expect(to < vertex_count);
+	}
+	vector<optional<EdgeData>> items;
+	items.reserve(payloads.size());
+	for (const auto [kind, owner] : payloads) {
+		if (kind == snapshot::EdgeKind::WAIT) {
+			expect(owner < loaded_stops.Size());
+			items.emplace_back(EdgeData{ Point::Type::WAIT, loaded_stops.names[owner] });
+		}
+		else if (kind == snapshot::EdgeKind::BUS) {
+			expect(owner < loaded_buses.Size());
+			items.emplace_back(EdgeData{ Point::Type::BUS, loaded_buses.names[owner] });
+		}
+		else {
+			expect(kind == snapshot::EdgeKind::TRANSFER);
+			items.emplace_back(nullopt);
+		}
+	}
+	for (const auto vertex : loaded_stops.root_vertices) {
+		expect(vertex < vertex_count);
+	}
+	for (const auto vertex : loaded_buses.waybill_vertices) {
+		expect(vertex < vertex_count);
+	}
+	return make_unique<TransportGraph>(
+		vector<uint32_t>(offsets.begin(), offsets.end()),
+		vector<uint32_t>(targets.begin(), targets.end()),
+		vector<double>(weights.begin(), weights.end()),
+		move(items)
+	);
+}
+
+unordered_map<string_view, TransportCatalog::RoadDistances> TransportCatalog::load_pending_distances(
+	const snapshot::Reader& reader,
+	size_t stop_count
+) const {
+	unordered_map<string_view, RoadDistances> loaded;
+	for (const auto& [name, distance, from, _] : reader.View<snapshot::PendingDistance>(snapshot::PENDING_DISTANCES)) {
+		expect(from < stop_count);
+		loaded[reader.GetString(name)].emplace_back(from, distance);
+	}
+	return loaded;
+}
+
+#ifdef RENDER
+void TransportCatalog::load_map_layout() {
+	collect_route_neighbours();
+	if (stops.map_indices.size() != stops.Size()) {
+		stops.map_indices.assign(stops.Size(), MapIndex{});
+		distribute_stops_on_x_axis();
+		distribute_stops_on_y_axis();
+	}
+	MapIndex max_idx;
+	for (const auto& [x_idx, y_idx] : stops.map_indices) {
+		max_idx.x_idx = max(max_idx.x_idx, x_idx);
+		max_idx.y_idx = max(max_idx.y_idx, y_idx);
+	}
+	step_info = calculate_step_settings(max_idx);
+	layer_cache.clear();
+	render_cache.reset();
+}
+#endif
@@ -0,0 +1,498 @@
+#include "transport_catalog.h"
+
+using geographic::Stop;
+using geographic::Bus;
+using namespace std;
+
+void TransportCatalog::UpdateStop(Stop stop_) {
+	if (!navigator) {
+		AddStop(move(stop_));
+		return;
+	}
+	const auto known_stop{ find_stop(stop_.name) };
+	const StopId stop{ known_stop ? *known_stop : add_stop(stop_.name) };
+#ifdef RENDER
+	const auto& previous_coordinates{ stops.coordinates[stop] };
+	const bool is_moved{
+		!known_stop
+		|| previous_coordinates.latitude != stop_.coordinates.latitude
+		|| previous_coordinates.longitude != stop_.coordinates.longitude
+	};
+#endif
+
+	/*Distances declared earlier by this stop to the unknown stops are replaced*/
+	drop_pending_distances(stop);
+	stops.coordinates[stop] = stop_.coordinates;
+	stops.trig.Set(stop, stop_.coordinates);
+	set_road_distances(stop, make_road_distances(stop, stop_.distances));
+
+	/*Only the segments with this stop are changed: the routes through it are laid again*/
+	const auto bus_list{ stops.GetBusList(stop) };
+	vector<BusId> affected_buses;
+	affected_buses.reserve(bus_list.size());
+	for (const auto bus_name : bus_list) {
+		affected_buses.push_back(*find_bus(bus_name));
+	}
+	for (const auto bus : affected_buses) {
+		detach_bus(bus);
+		attach_bus(bus);
+		update_route_stats(bus);
+	}
+	finish_delta();
+#ifdef RENDER
+	if (is_moved) {
+		update_map_layout(false);
+	}
+#endif
+}
+
+void TransportCatalog::UpdateBus(Bus bus_) {
+	if (!navigator) {
+		AddBus(move(bus_));
+		return;
+	}
+	if (bus_.is_roundtrip) {
+		bus_.stops.pop_back();											//Remove duplicate final stop
+	}
+
+	const auto known_bus{ find_bus(bus_.name) };
+	const BusId bus{ known_bus ? *known_bus : add_bus(bus_.name) };
+	if (known_bus && buses.is_active[bus]) {
+		detach_bus(bus);
+		garbage.waybill_items += buses.GetWaybill(bus).size();
+	}
+	else if (known_bus) {												//The removed bus is restored
+		buses.is_active[bus] = true;
+		buses.by_name.insert(
+			lower_bound(buses.by_name.begin(), buses.by_name.end(), bus, [this](BusId lhs, BusId rhs) {
+				return buses.names[lhs] < buses.names[rhs];
+				}),
+			bus
+		);
+	}
+
+	/*The new waybill is appended, the previous one is left unused*/
+	const auto first{ static_cast<uint32_t>(buses.waybill_stops.size()) };
+	for (const auto stop_name : bus_.stops) {
+		const auto stop{ find_stop(stop_name) };						//The bus can go through stops that aren't yet in the database
+		buses.waybill_stops.push_back(stop ? *stop : add_stop(stop_name));
+	}
+	buses.waybill_bounds[bus] = { first, static_cast<uint32_t>(buses.waybill_stops.size()) };
+	buses.waybill_vertices.resize(buses.waybill_stops.size());
+	resize_segments();
+	buses.is_roundtrip[bus] = bus_.is_roundtrip;
+
+	attach_bus(bus);
+	update_route_stats(bus);
+	finish_delta();
+#ifdef RENDER
+	update_map_layout(true);
+#endif
+}
+
+bool TransportCatalog::RemoveBus(string_view bus_name_) {
+	const auto bus{ find_bus(bus_name_) };
+	if (!navigator || !bus || !buses.is_active[*bus]) {
+		return false;
+	}
+
+	detach_bus(*bus);
+	garbage.waybill_items += buses.GetWaybill(*bus).size();				//Dropped at the compaction
+	buses.is_active[*bus] = false;
+	buses.by_name.erase(find(buses.by_name.begin(), buses.by_name.end(), *bus));
+	buses.stats[*bus] = nullopt;
+	touch_bus(*bus);
+	finish_delta();
+#ifdef RENDER
+	update_map_layout(true);
+#endif
+	return true;
+}
+
+const TransportCatalog::Compactions& TransportCatalog::GetCompactions() const noexcept {
+	return compactions;
+}
+
+TransportCatalog::StopId TransportCatalog::add_stop(string_view stop_name) {
+	const auto stop{ static_cast<StopId>(stops.Size()) };
+	stops.names.push_back(stop_name);
+	stops.by_name.insert(
+		lower_bound(stops.by_name.begin(), stops.by_name.end(), stop_name, [this](StopId lhs, string_view rhs) {
+			return stops.names[lhs] < rhs;
+			}),
+		stop
+	);
+	stops.coordinates.emplace_back();
+	stops.trig.PushBack({});
+	stops.distance_bounds.push_back({ 0, 0 });
+	stops.root_vertices.push_back(thaw_graph().AddVertex());
+	stops.bus_passes.push_back(0);
+	stops.bus_bounds.emplace_back(0, 0);
+#ifdef RENDER
+	stops.map_indices.emplace_back();
+#endif
+	added_stop_ids.emplace(stop_name, stop);
+	stop_revisions.push_back(++last_revision);							//The stop was "not found" before
+
+	/*Distances declared by other stops before this one was added*/
+	for (const auto& [from, distance] : take_pending_distances(stop_name)) {
+		const auto previous{ stops.GetRoadDistances(from) };
+		RoadDistances distances(previous.begin(), previous.end());		//The previous slice is left unused
+		distances.emplace_back(stop, distance);
+		set_road_distances(from, move(distances));
+	}
+	return stop;
+}
+
+TransportCatalog::BusId TransportCatalog::add_bus(string_view bus_name) {
+	const auto bus{ static_cast<BusId>(buses.Size()) };
+	buses.names.push_back(bus_name);
+	buses.by_name.insert(
+		lower_bound(buses.by_name.begin(), buses.by_name.end(), bus_name, [this](BusId lhs, string_view rhs) {
+			return buses.names[lhs] < rhs;
+			}),
+		bus
+	);
+	buses.is_roundtrip.push_back(false);
+	buses.is_active.push_back(true);
+	buses.waybill_bounds.emplace_back(0, 0);
+	buses.stats.emplace_back();
+	added_bus_ids.emplace(bus_name, bus);
+	bus_revisions.push_back(++last_revision);
+	return bus;
+}
+
+void TransportCatalog::detach_bus(BusId bus) {
+	const auto [first, last] { buses.waybill_bounds[bus] };
+	garbage.vertices += last - first;									//New vertices are added on attach
+	for (uint32_t pos = first; pos < last; ++pos) {
+		const StopId stop{ buses.waybill_stops[pos] };
+		const VertexId bus_vertex{ buses.waybill_vertices[pos] };
+
+		/*All the route edges of the bus start from its vertices*/
+		vector<EdgeId> outgoing_edges;
+		for (const auto& [_, edge_id] : thaw_graph().GetIncidentRange(bus_vertex)) {
+			outgoing_edges.push_back(edge_id);
+		}
+		for (const auto edge_id : outgoing_edges) {
+			remove_edge(edge_id);
+		}
+		remove_edge(thaw_graph().GetEdgeId(stops.root_vertices[stop], bus_vertex));
+		--stops.bus_passes[stop];
+	}
+	for (uint32_t pos = first; pos < last; ++pos) {
+		remove_from_bus_list(buses.waybill_stops[pos], buses.names[bus]);
+	}
+}
+
+void TransportCatalog::attach_bus(BusId bus) {
+	using routing::Point;
+	const auto [first, last] { buses.waybill_bounds[bus] };
+	for (uint32_t pos = first; pos < last; ++pos) {
+		const StopId stop{ buses.waybill_stops[pos] };
+		const VertexId root_vertex{ stops.root_vertices[stop] },
+			bus_vertex{ thaw_graph().AddVertex() };						//Vertices of the previous route are left isolated
+		buses.waybill_vertices[pos] = bus_vertex;
+		++stops.bus_passes[stop];
+
+		add_edge(Edge{
+			root_vertex,
+			bus_vertex,
+			static_cast<double>(routing_settings->bus_wait_time),
+			EdgeData{ Point::Type::WAIT, stops.names[stop] }
+			});
+		add_edge(Edge{ bus_vertex, root_vertex, 0, nullopt });
+		insert_into_bus_list(stop, buses.names[bus]);
+	}
+	measure_segments(bus);
+	for (const auto& edge : make_route_edges(bus)) {
+		add_edge(edge);
+	}
+}
+
+TransportCatalog::TransportGraphBuilder& TransportCatalog::thaw_graph() {
+	if (!graph_builder) {
+		graph_builder = make_unique<TransportGraphBuilder>(graph->Thaw());
+	}
+	return *graph_builder;
+}
+
+void TransportCatalog::finish_delta() {
+	if (graph_builder) {												//The graph was changed
+		has_graph_changes = true;
+	}
+	collect_garbage();
+}
+
+void TransportCatalog::flush_graph_changes() const {
+#ifdef MULTITHREADING
+	if (!has_graph_changes.load(memory_order_acquire)) {
+		return;
+	}
+	lock_guard guard(graph_flush_mutex);
+	if (!has_graph_changes.load(memory_order_relaxed)) {				//Another search has flushed the batch
+		return;
+	}
+#else
+	if (!has_graph_changes) {
+		return;
+	}
+#endif
+	if (graph_builder) {
+		vector<EdgeId> added_ids(graph_changes.added.begin(), graph_changes.added.end());
+		sort(added_ids.begin(), added_ids.end());
+		vector<Edge> added_edges;
+		added_edges.reserve(added_ids.size());
+		for (const auto edge_id : added_ids) {
+			added_edges.push_back(graph_builder->GetEdge(edge_id));
+		}
+		*graph = TransportGraph(*graph_builder);						//Refrozen in place: the navigator refers to it
+		graph_builder.reset();											//Only the frozen graph is kept between the batches
+		navigator->OnGraphUpdate(graph_changes.removed, added_edges);
+	}
+	components = Graph::Components(*graph);								//The components can split or merge
+	graph_changes = GraphChanges{};
+#ifdef MULTITHREADING
+	has_graph_changes.store(false, memory_order_release);
+#else
+	has_graph_changes = false;
+#endif
+}
+
+void TransportCatalog::reset_delta_state() {
+	graph_builder.reset();
+	graph_changes = GraphChanges{};
+	has_graph_changes = false;
+	garbage = Garbage{};
+	compactions = Compactions{};
+}
+
+void TransportCatalog::update_route_stats(BusId bus) {
+#ifdef MULTITHREADING
+	buses.stats[bus] = calculate_single_route_stats(bus);
+#else	/*Lazy calculation*/
+	buses.stats[bus] = nullopt;
+#endif
+	touch_bus(bus);
+}
+
+void TransportCatalog::reset_revisions() {
+	++last_revision;
+	stop_revisions.assign(stops.Size(), last_revision);
+	bus_revisions.assign(buses.Size(), last_revision);
+}
+
+void TransportCatalog::touch_stop(StopId stop) {
+	stop_revisions[stop] = ++last_revision;
+}
+
+void TransportCatalog::touch_bus(BusId bus) {
+	bus_revisions[bus] = ++last_revision;
+}
+
+void TransportCatalog::remove_edge(EdgeId edge_id) {
+	TransportGraphBuilder& builder{ thaw_graph() };
+	if (edge_id < graph->GetEdgeCount()) {								//The builder keeps the ids of the frozen edges
+		graph_changes.removed.push_back(builder.GetEdge(edge_id));
+	}
+	else {
+		graph_changes.added.erase(edge_id);
+	}
+	builder.RemoveEdge(edge_id);
+}
+
+void TransportCatalog::add_edge(const Edge& edge) {
+	graph_changes.added.insert(thaw_graph().AddEdge(edge));
+}
+
+void TransportCatalog::remove_from_bus_list(StopId stop, string_view bus_name) {
+	auto& [first, last] { stops.bus_bounds[stop] };
+	const auto list_first{ stops.bus_names.begin() + first },
+		list_last{ stops.bus_names.begin() + last };
+	if (auto it = lower_bound(list_first, list_last, bus_name); it != list_last && *it == bus_name) {
+		move(next(it), list_last, it);									//The list is shrunk in place
+		--last;
+		++garbage.bus_list_items;
+		touch_stop(stop);
+	}
+}
+
+void TransportCatalog::insert_into_bus_list(StopId stop, string_view bus_name) {
+	const auto bus_list{ stops.GetBusList(stop) };
+	const auto it{ lower_bound(bus_list.begin(), bus_list.end(), bus_name) };
+	if (it != bus_list.end() && *it == bus_name) {
+		return;
+	}
+
+	/*The extended list is appended, the previous one is left unused*/
+	const auto first{ static_cast<uint32_t>(stops.bus_names.size()) };
+	const vector<string_view> previous(bus_list.begin(), bus_list.end());
+	const auto insert_pos{ it - bus_list.begin() };
+	stops.bus_names.insert(stops.bus_names.end(), previous.begin(), previous.begin() + insert_pos);
+	stops.bus_names.push_back(bus_name);
+	stops.bus_names.insert(stops.bus_names.end(), previous.begin() + insert_pos, previous.end());
+	stops.bus_bounds[stop] = { first, static_cast<uint32_t>(stops.bus_names.size()) };
+	garbage.bus_list_items += previous.size();
+	touch_stop(stop);
+}
+
+void TransportCatalog::add_pending_distance(StopId from, string_view stop_name, uint64_t distance) {
+	pending_road_distances[stop_name].emplace_back(from, distance);
+	pending_neighbours[from].push_back(stop_name);
+}
+
+void TransportCatalog::drop_pending_distances(StopId from) {
+	/*Only the unknown stops the stop has declared distances to are visited*/
+	auto node{ pending_neighbours.extract(from) };
+	if (!node) {
+		return;
+	}
+	for (const auto stop_name : node.mapped()) {
+		if (auto it = pending_road_distances.find(stop_name); it != pending_road_distances.end()) {
+			erase_if(it->second, [from](const auto& item) {
+				return item.first == from;
+				});
+			if (it->second.empty()) {
+				pending_road_distances.erase(it);
+			}
+		}
+	}
+}
+
+TransportCatalog::RoadDistances TransportCatalog::take_pending_distances(string_view stop_name) {
+	auto node{ pending_road_distances.extract(stop_name) };
+	if (!node) {
+		return {};
+	}
+	for (const auto& [from, _] : node.mapped()) {
+		if (auto it = pending_neighbours.find(from); it != pending_neighbours.end()) {
+			erase(it->second, stop_name);
+			if (it->second.empty()) {
+				pending_neighbours.erase(it);
+			}
+		}
+	}
+	return move(node.mapped());
+}
+
+void TransportCatalog::index_pending_distances() {
+	pending_neighbours.clear();
+	for (const auto& [stop_name, distances] : pending_road_distances) {
+		for (const auto& [from, _] : distances) {
+			pending_neighbours[from].push_back(stop_name);
+		}
+	}
+}
+
+void TransportCatalog::collect_garbage() {
+	auto is_wasteful{ [](size_t unused, size_t total) {
+		return unused > total - unused;
+	} };
+	const size_t vertex_count{ graph_builder ? graph_builder->GetVertexCount() : graph->GetVertexCount() };
+	if (is_wasteful(garbage.vertices, vertex_count)) {
+		compact_graph();
+		++compactions.graphs;
+	}
+	else if (is_wasteful(garbage.waybill_items, buses.waybill_stops.size())) {
+		compact_waybills();
+		++compactions.waybills;
+	}
+	if (is_wasteful(garbage.bus_list_items, stops.bus_names.size())) {
+		compact_bus_lists();
+		++compactions.bus_lists;
+	}
+	if (is_wasteful(garbage.road_distances, stops.road_distances.size())) {
+		compact_road_distances();
+		++compactions.road_distances;
+	}
+}
+
+void TransportCatalog::compact_waybills() {
+	BusesTable compacted;
+	const size_t used{ buses.waybill_stops.size() - garbage.waybill_items };
+	compacted.waybill_stops.reserve(used);
+	compacted.waybill_vertices.reserve(used);
+	compacted.forward_segments.reserve(used);
+	compacted.backward_segments.reserve(used);
+	for (BusId bus = 0; bus < buses.Size(); ++bus) {
+		const auto [first, last] { buses.waybill_bounds[bus] };
+		const auto compacted_first{ static_cast<uint32_t>(compacted.waybill_stops.size()) };
+		if (buses.is_active[bus]) {											//UpdateBus gives the removed bus a new waybill
+			auto copy_range{ [first, last](const auto& from, auto* to) {
+				to->insert(to->end(), from.begin() + first, from.begin() + last);
+			} };
+			copy_range(buses.waybill_stops, addressof(compacted.waybill_stops));
+			copy_range(buses.waybill_vertices, addressof(compacted.waybill_vertices));
+			copy_range(buses.forward_segments, addressof(compacted.forward_segments));
+			copy_range(buses.backward_segments, addressof(compacted.backward_segments));
+		}
+		buses.waybill_bounds[bus] = { compacted_first, static_cast<uint32_t>(compacted.waybill_stops.size()) };
+	}
+	buses.waybill_stops = move(compacted.waybill_stops);
+	buses.waybill_vertices = move(compacted.waybill_vertices);
+	buses.forward_segments = move(compacted.forward_segments);
+	buses.backward_segments = move(compacted.backward_segments);
+	garbage.waybill_items = 0;
+}
+
+void TransportCatalog::compact_bus_lists() {
+	vector<string_view> bus_names;
+	bus_names.reserve(stops.bus_names.size() - garbage.bus_list_items);
+	for (StopId stop = 0; stop < stops.Size(); ++stop) {
+		const auto bus_list{ stops.GetBusList(stop) };
+		const auto first{ static_cast<uint32_t>(bus_names.size()) };
+		bus_names.insert(bus_names.end(), bus_list.begin(), bus_list.end());
+		stops.bus_bounds[stop] = { first, static_cast<uint32_t>(bus_names.size()) };
+	}
+	stops.bus_names = move(bus_names);
+	garbage.bus_list_items = 0;
+}
+
+void TransportCatalog::compact_road_distances() {
+	vector<RoadDistance> road_distances;
+	road_distances.reserve(stops.road_distances.size() - garbage.road_distances);
+	for (StopId stop = 0; stop < stops.Size(); ++stop) {
+		const auto distances{ stops.GetRoadDistances(stop) };
+		const auto first{ static_cast<uint32_t>(road_distances.size()) };
+		road_distances.insert(road_distances.end(), distances.begin(), distances.end());
+		stops.distance_bounds[stop] = { first, static_cast<uint32_t>(road_distances.size()) };
+	}
+	stops.road_distances = move(road_distances);
+	garbage.road_distances = 0;
+}
+
+void TransportCatalog::compact_graph() {
+	if (graph_builder) {
+		*graph = TransportGraph(*graph_builder);
+		graph_builder.reset();
+	}
+	compact_waybills();													//The vertices of the removed buses are unused now
+
+	/*The used vertices are renumbered in the same order*/
+	vector<uint32_t> new_ids(graph->GetVertexCount(), TransportGraph::dropped);
+	for (const auto vertex : stops.root_vertices) {
+		new_ids[vertex] = 0;
+	}
+	for (const auto vertex : buses.waybill_vertices) {
+		new_ids[vertex] = 0;
+	}
+	uint32_t next_id{ 0 };
+	for (auto& new_id : new_ids) {
+		if (new_id != TransportGraph::dropped) {
+			new_id = next_id++;
+		}
+	}
+	*graph = graph->Compact(new_ids);									//Compacted in place: the navigator refers to it
+	for (auto& vertex : stops.root_vertices) {
+		vertex = new_ids[vertex];
+	}
+	for (auto& vertex : buses.waybill_vertices) {
+		vertex = new_ids[vertex];
+	}
+
+	/*The cached trees refer to the previous ids; the components are found at the flush*/
+	navigator = make_unique<Navigator>(*graph);
+	graph_changes = GraphChanges{};
+	has_graph_changes = true;
+	garbage.vertices = 0;
+}
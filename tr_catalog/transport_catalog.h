@@ -6,26 +6,36 @@
 #include "stats.h"
 #include "routing.h"
 
+/*Name lookups*/
+#include "perfect_hash.h"
+
 /*Routing*/
 #include "navigator.h"
+#include "components.h"
+#include "frozen_graph.h"
 #include "graph.h"
 
+/*Binary snapshot format*/
+#include "snapshot.h"
+
 /*Standart headers*/
-#ifdef RENDER
-#include <map>
-#else
 #include <unordered_map>
-#endif
 #include <unordered_set>
+#include <initializer_list>
 #include <string>
 #include <string_view>
 #include <optional>
 #include <tuple>
 #include <vector>
+#include <span>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <utility>
 #include <memory>
 #include <algorithm>
+#include <numeric>
+#include <stdexcept>
 
 #ifdef RENDER
 /*SVG Graphics*/
@@ -37,20 +47,34 @@
 #endif
 
 
+/*Synchronize stages timing*/
+#include <array>
+#include <chrono>
+
 #ifdef MULTITHREADING
-/*Thread safety*/
-#include <mutex>	
+/*Contention-free staging*/
+#include "per_thread.h"
+
+/*Lazy graph update*/
+#include <atomic>
+#include <mutex>
+
+/*Synchronize stages run on the thread pool*/
+#include <ranges>
+#include "execution.h"
 #endif
 
 class TransportCatalog {
 private:
 	/*Type alias section #1*/
-	using BusId = std::string_view;
-	using StopId = std::string_view;
+	using StopId = uint32_t;												//Dense ids are assigned alphabetically at Synchronize
+	using BusId = uint32_t;
 	using VertexId = Graph::VertexId;
-	using BusList = std::set<BusId>;
-	using BusListIt = BusList::const_iterator;
-	using Waybill = std::vector<StopId>;
+	using EdgeId = Graph::EdgeId;
+	using BusListIt = std::vector<std::string_view>::const_iterator;
+	using Waybill = std::span<const StopId>;
+	using RoadDistance = std::pair<StopId, uint64_t>;
+	using RoadDistances = std::vector<RoadDistance>;
 
 #ifdef RENDER
 	/*Coordinates compression*/
@@ -58,33 +82,79 @@ private:
 		size_t
 			x_idx{ 0 },
 			y_idx{ 0 };
-	};
-#endif
 
-	struct Navigation {
-		std::optional<VertexId> root_vertex_id;
-		size_t bus_passes_count{ 0 };											//The bus can go through the stop several times
+		bool operator==(const MapIndex&) const = default;
 	};
+#endif
 
-	/*Stops, buses and graph edge data holders*/
-	struct StopHolder {
-		geographic::Coordinates coordinates;
-		geographic::DistanceList distance_list;
-		BusList bus_list;
-		Navigation navigation;
+	/*[first, last) positions in a shared array*/
+	using Bounds = std::pair<uint32_t, uint32_t>;
+
+	/*Stops and buses are stored as struct of arrays indexed by id.
+	Ids of the stops and buses added after Synchronize don't follow the alphabetical order*/
+	struct StopsTable {
+		std::vector<std::string_view> names;
+		std::vector<StopId> by_name;										//Alphabetical order
+		std::vector<geographic::Coordinates> coordinates;
+		geographic::TrigTable trig;											//Kept in sync with coordinates
+		std::vector<VertexId> root_vertices;
+		std::vector<uint32_t> bus_passes;									//The bus can go through the stop several times
+
+		/*Buses of the stop (sorted alphabetically) are a range of bus_names*/
+		std::vector<Bounds> bus_bounds;
+		std::vector<std::string_view> bus_names;
+
+		/*Road distances declared by the stop (sorted by the neighbour id) are a range of road_distances*/
+		std::vector<Bounds> distance_bounds;
+		std::vector<RoadDistance> road_distances;
 #ifdef RENDER
-		MapIndex index_on_map;
+		std::vector<MapIndex> map_indices;
 #endif
+
+		size_t Size() const noexcept {
+			return names.size();
+		}
+		std::span<const std::string_view> GetBusList(StopId stop) const noexcept {
+			return std::span(bus_names).subspan(bus_bounds[stop].first, bus_bounds[stop].second - bus_bounds[stop].first);
+		}
+		std::span<const RoadDistance> GetRoadDistances(StopId stop) const noexcept {
+			return std::span(road_distances).subspan(
+				distance_bounds[stop].first,
+				distance_bounds[stop].second - distance_bounds[stop].first
+			);
+		}
 	};
 
-	struct BusHolder {
-		Waybill waybill;													
-		bool is_roundtrip;
+	struct BusesTable {
+		std::vector<std::string_view> names;
+		std::vector<BusId> by_name;											//Alphabetical order of the active buses
+		std::vector<bool> is_roundtrip;
+		std::vector<bool> is_active;										//False for the removed buses
+
+		/*Waybill of the bus is a range of waybill_stops. Each stop of the waybill has its own bus vertex*/
+		std::vector<Bounds> waybill_bounds;
+		std::vector<StopId> waybill_stops;
+		std::vector<VertexId> waybill_vertices;
+
+		/*Segment distances (indexed like waybill_stops): forward from the stop to the next one
+		(from the last stop to the first one for roundtrip routes), backward in the opposite direction*/
+		std::vector<stats::Distance> forward_segments;
+		std::vector<stats::Distance> backward_segments;
 #ifdef MULTITHREADING
-		std::optional<stats::Route> stats;
+		std::vector<std::optional<stats::Route>> stats;
 #else	/*Lazy calculation*/
-		mutable std::optional<stats::Route> stats;
+		mutable std::vector<std::optional<stats::Route>> stats;
 #endif
+
+		size_t Size() const noexcept {
+			return names.size();
+		}
+		Waybill GetWaybill(BusId bus) const noexcept {
+			return Waybill(waybill_stops).subspan(
+				waybill_bounds[bus].first,
+				waybill_bounds[bus].second - waybill_bounds[bus].first
+			);
+		}
 	};
 
 	struct EdgeData {
@@ -97,40 +167,64 @@ private:
 		double
 			x_step{ 0 },
 			y_step{ 0 };
+
+		bool operator==(const Step&) const = default;
 	};
 	
-	/*Type alias section #2 (databases)*/
-#ifdef RENDER
-	/*Buses and stops must be sorted alphabetically*/
-	template <class Key, class Value>
-	using Database = std::map<Key, Value>;
-#else
-	/*Versions without render*/
-	template <class Key, class Value>
-	using Database = std::unordered_map<Key, Value>;
-#endif
-	using StopsDatabase = Database<StopId, StopHolder>;
-	using BusDatabase = Database<BusId, BusHolder>;
-	using StopHandleIt = StopsDatabase::iterator;
-	using StopIt = StopsDatabase::const_iterator;
-	using BusHandleIt = BusDatabase::iterator;
-	using BusIt = BusDatabase::const_iterator;
+	/*Type alias section #2 (name to id maps: the names are frozen at Synchronize)*/
+	template <class Id>
+	using NameIndex = algo::hash::PerfectHashIndex<Id>;
 
 	/*Type alias section #3 (navigation)*/
 	using Weight = double;
-	using TransportGraph = Graph::DirectedWeightedGraph<Weight, std::optional<EdgeData>>;
+	using TransportGraphBuilder = Graph::DirectedWeightedGraph<Weight, std::optional<EdgeData>>;
+	using TransportGraphBuilderHolder = std::unique_ptr<TransportGraphBuilder>;
+	using TransportGraph = Graph::FrozenGraph<Weight, std::optional<EdgeData>>;	//CSR form for the navigation
 	using TransportGraphHolder = std::unique_ptr<TransportGraph>;
-	using Edge = TransportGraph::Edge;
+	using Edge = TransportGraphBuilder::Edge;
 	using Navigator = Graph::Navigator<TransportGraph>;
 	using NavigatorHolder = std::unique_ptr<Navigator>;
 	using TransportGraphRoute = Navigator::Route;
 
+	/*Requests are staged as is until Synchronize*/
+	struct Staging {
+		std::vector<geographic::Stop> stops;
+		std::vector<geographic::Bus> buses;
+	};
+
+	/*Synchronize stages (the order is the order of GetSyncStats)*/
+	enum SyncStage : size_t {
+		INTERNING,
+		SEGMENTS,
+		TYING,
+		GRAPH,
+		NAVIGATOR,
+		COMPONENTS,
 #ifdef MULTITHREADING
-	/*Type alias section #4 (thread-safety)*/
-	using Guard = std::lock_guard<std::mutex>;
+		ROUTE_STATS,
 #endif
+#ifdef RENDER
+		MAP_X_AXIS,
+		MAP_Y_AXIS,
+#endif
+		TOTAL,
+		SYNC_STAGE_COUNT
+	};
 
 public:
+	struct SyncStageTiming {
+		std::string_view stage;
+		std::chrono::microseconds duration{ 0 };
+	};
+
+	/*Compactions of the arrays left with unused items by the deltas (the graph compaction includes the waybills)*/
+	struct Compactions {
+		size_t graphs{ 0 };
+		size_t waybills{ 0 };
+		size_t bus_lists{ 0 };
+		size_t road_distances{ 0 };
+	};
+
 	/*Database update methods*/
 	TransportCatalog& AddStop(geographic::Stop stop_);		
 	TransportCatalog& AddBus(geographic::Bus bus_);
@@ -139,13 +233,52 @@ public:
 	void SetRenderSettings(render::Settings render_settings_);
 #endif
 
-	/*Synchronization and statistics collection*/
+	/*Synchronization and statistics collection. It runs once (std::logic_error on a synchronized
+	or loaded catalog): the later changes are the deltas*/
 	void Synchronize();
+#ifdef MULTITHREADING
+	/*Stages are run as a dependency graph on the thread pool (Synchronize() waits for it)*/
+	algo::execution::Task<void> SynchronizeAsync();
+#endif
+
+	/*After Synchronize or LoadSnapshot*/
+	bool IsSynchronized() const noexcept;
+
+	/*Duration of the last Synchronize stages. Concurrent stages overlap, so they don't add up to the total*/
+	std::vector<SyncStageTiming> GetSyncStats() const;
+
+	/*Deltas for the synchronized catalog: only the affected routes, graph edges, navigator cache entries
+	and map layers are updated (they must not run concurrently with each other and with the search methods).
+	The graph changes are batched: the graph is refrozen and the navigator and the components are updated
+	once on the next GetRouting or SaveSnapshot. Before Synchronize the stops and buses are staged like AddStop/AddBus*/
+	void UpdateStop(geographic::Stop stop_);								//Adds the stop or replaces its coordinates and distances
+	void UpdateBus(geographic::Bus bus_);									//Adds the bus or replaces its route
+	bool RemoveBus(std::string_view bus_name_);
+
+	/*Since the last Synchronize or LoadSnapshot*/
+	const Compactions& GetCompactions() const noexcept;
+
+	/*Binary snapshot of the synchronized catalog. LoadSnapshot maps the file and replaces the databases,
+	the graph and the map layout without rebuilding them (the names refer to the mapped file).
+	Routing settings are saved; render settings are not, so they are set before LoadSnapshot*/
+	void SaveSnapshot(const std::string& path) const;
+	void LoadSnapshot(const std::string& path);
 
 	/*Database search methods*/
 	std::optional<stats::Route> GetBusInfo(std::string_view bus_name_) const;
 	std::optional<stats::Stop<BusListIt>> GetStopInfo(std::string_view bus_name_) const;
 	std::optional<routing::OnMap> GetRouting(const routing::Bounds& segment) const;
+
+	/*Names in alphabetical order (the removed buses are skipped)*/
+	std::vector<std::string_view> GetStopNames() const;
+	std::vector<std::string_view> GetBusNames() const;
+
+	/*Dense ids for the answer caches: stable until the next Synchronize or LoadSnapshot.
+	The revision of an id changes whenever a delta changes its Bus or Stop answer*/
+	std::optional<StopId> FindStopId(std::string_view stop_name_) const;
+	std::optional<BusId> FindBusId(std::string_view bus_name_) const;		//The removed buses aren't found
+	uint64_t GetStopRevision(StopId stop) const noexcept;
+	uint64_t GetBusRevision(BusId bus) const noexcept;
 #ifdef RENDER
 	/*SVG rendering methods*/
 	const svg::Document& GetMap() const;
@@ -153,27 +286,107 @@ public:
 
 private:
 	/*Calculation of travel statistics*/
-	void calculate_all_routes_stats();
-	stats::Route calculate_single_route_stats(const Waybill& waybill, bool is_roundtrip) const;
+#ifdef MULTITHREADING
+	algo::execution::Task<void> calculate_all_routes_stats();
+#endif
+	stats::Route calculate_single_route_stats(BusId bus) const;
 
 	/*Multi-thread and single-thread versions are different*/
-	std::optional<stats::Route> get_bus_route_stats(BusIt bus) const;
+	std::optional<stats::Route> get_bus_route_stats(BusId bus) const;
+
+	/*Names interning: staged stops and buses are moved to the tables*/
+	void intern_staged();
+	Staging take_staged();
+	void intern_stops(const std::vector<geographic::Stop>& new_stops, const std::vector<geographic::Bus>& new_buses);
+	void intern_buses(std::vector<geographic::Bus> new_buses);
+	RoadDistances make_road_distances(StopId stop, const geographic::DistanceList& distances);
+	void set_road_distances(StopId stop, RoadDistances distances);		//The previous range is left unused
+
+	/*Distances to the unknown stops: indexed both by the unknown name and by the declaring stop*/
+	void add_pending_distance(StopId from, std::string_view stop_name, uint64_t distance);
+	void drop_pending_distances(StopId from);
+	RoadDistances take_pending_distances(std::string_view stop_name);
+	void index_pending_distances();
+
+	/*Name lookups (the names added after Synchronize aren't in the perfect hash)*/
+	std::optional<StopId> find_stop(std::string_view stop_name) const;
+	std::optional<BusId> find_bus(std::string_view bus_name) const;		//Removed buses too
+	StopId get_stop(std::string_view stop_name) const;					//Throws std::out_of_range
 
 	/*Sync stops and buses info*/
 	void tie_stops_with_buses();
 
-	/*Stop root_vertex_index initialization to build a graph*/
-	static size_t initialize_root_vertex_index(StopsDatabase* stops_base) noexcept;
+	/*Root and bus vertices initialization to build a graph*/
+	size_t initialize_vertices();
+
+	/*Deltas*/
+	StopId add_stop(std::string_view stop_name);
+	BusId add_bus(std::string_view bus_name);
+	void detach_bus(BusId bus);
+	void attach_bus(BusId bus);
+	void update_route_stats(BusId bus);
+	void reset_revisions();												//All the answers are new
+	void touch_stop(StopId stop);
+	void touch_bus(BusId bus);
+	void remove_from_bus_list(StopId stop, std::string_view bus_name);
+	void insert_into_bus_list(StopId stop, std::string_view bus_name);
+
+	/*Graph changes of the deltas: the edges are changed in the builder, the navigator gets the net changes
+	of the whole batch at the flush (an edge added and removed within the batch isn't passed)*/
+	struct GraphChanges {
+		std::vector<Edge> removed;										//Edges of the frozen graph
+		std::unordered_set<EdgeId> added;								//Builder edges beyond the frozen ones
+	};
+	TransportGraphBuilder& thaw_graph();
+	void remove_edge(EdgeId edge_id);
+	void add_edge(const Edge& edge);
+	void finish_delta();
+	void flush_graph_changes() const;									//Before the navigation searches
+	void reset_delta_state();
+
+	/*Unused ranges and vertices left by the deltas: an array is compacted when they outnumber the used items,
+	so the compaction costs O(1) per abandoned item in amortized terms*/
+	struct Garbage {
+		size_t waybill_items{ 0 };
+		size_t bus_list_items{ 0 };
+		size_t road_distances{ 0 };
+		size_t vertices{ 0 };
+	};
+	void collect_garbage();
+	void compact_waybills();											//The removed buses lose their waybills
+	void compact_bus_lists();
+	void compact_road_distances();
+	void compact_graph();												//The navigator cache is dropped
+
+	/*Snapshot sections*/
+	void save_stops(snapshot::Writer* writer) const;
+	void save_buses(snapshot::Writer* writer) const;
+	void save_graph(snapshot::Writer* writer) const;
+	void save_pending_distances(snapshot::Writer* writer) const;
+	BusesTable load_buses(const snapshot::Reader& reader) const;
+	StopsTable load_stops(const snapshot::Reader& reader, const BusesTable& loaded_buses) const;
+	TransportGraphHolder load_graph(
+		const snapshot::Reader& reader,
+		const StopsTable& loaded_stops,
+		const BusesTable& loaded_buses
+	) const;
+	std::unordered_map<std::string_view, RoadDistances> load_pending_distances(
+		const snapshot::Reader& reader,
+		size_t stop_count
+	) const;
+#ifdef RENDER
+	void load_map_layout();
+#endif
 
-	/*Distance calculation*/
-	static stats::Distance calc_distance(
-		const StopsDatabase::value_type& first,
-		const StopsDatabase::value_type& second
-	);
-	static std::optional<double> calc_real_distance(
-		const StopsDatabase::value_type& first,
-		const StopsDatabase::value_type& second
-	);
+	/*Distance calculation (the segments are measured once for the stats and the graph).
+	Geographic lengths come in batches: the whole database at Synchronize, a single route on update*/
+	std::optional<double> calc_real_distance(StopId first, StopId second) const;
+	void resize_segments();
+	void set_segment_ends(BusId bus, std::span<StopId> ends) const;
+	std::vector<double> measure_geographic_lengths() const;
+	void measure_segments(BusId bus, std::span<const double> lengths);
+	void measure_segments(BusId bus);
+	void measure_all_segments();
 
 	/*Navigation settings*/
 	struct GraphBuildSettings {
@@ -181,45 +394,66 @@ private:
 		size_t vertex_count;
 	};
 
-	/*Graph construction*/
-	TransportGraphHolder make_graph(size_t vertex_count);
+#ifdef MULTITHREADING
+	/*Graph, navigator and map stages*/
+	algo::execution::Task<void> build_navigation();
+	algo::execution::Task<void> build_graph(size_t vertex_count);
+	algo::execution::Task<void> find_components();
+#ifdef RENDER
+	algo::execution::Task<void> layout_map();
+#endif
+
+	template <class Id, class Function>
+	static algo::execution::Task<void> for_each_id(size_t id_count, Function func);
+	template <class Function>
+	static algo::execution::Task<void> run_on_pool(Function func);
+#endif
+
+	/*Graph construction (the route edges of each bus are independent)*/
+	TransportGraphHolder make_graph(size_t vertex_count, const std::vector<std::vector<Edge>>& route_edges) const;
+	std::vector<Edge> make_route_edges(BusId bus) const;
 
 	/*Adding dummy stops for each route*/
-	void add_transitional_stops(TransportGraph* graph);
+	void add_transitional_stops(TransportGraphBuilder* graph) const;
 	static void connect_transitional_stops(
-		TransportGraph* graph,
+		TransportGraphBuilder* graph,
 		std::pair<size_t, size_t> vertices,
 		double wait_time,
 		std::string_view stop_name
 	);
 
-	/*Adding route adges to the graph*/
-	void add_route_edges(
-		TransportGraph* graph,
+	/*Route edge between two bus vertices*/
+	Edge make_route_edge(
 		std::pair<VertexId, VertexId> from_to,
 		double distance,
 		std::string_view bus_name
-	);
+	) const;
 
 	/*Assembly of the route from the edges of the graph*/
 	routing::OnMap collect_route_points(const TransportGraphRoute& graph_route) const;
-	static routing::Point make_routing_point(const TransportCatalog::Edge& edge) noexcept;
+	static routing::Point make_routing_point(const EdgeData& item, Weight weight) noexcept;
 
 #ifdef RENDER
 	/*SVG map rendering*/
 	svg::Document render_map() const;
 	std::unique_ptr<Step> calculate_step_settings(MapIndex max_index) const;
 
-	static std::vector<StopHandleIt> collect_stops_location(StopsDatabase& stops);
-	MapIndex distribute_stops_on_map();
+	static std::vector<StopId> collect_stops_location(const StopsTable& stops);
+	size_t distribute_stops_on_x_axis();
+	size_t distribute_stops_on_y_axis();
 
-	bool are_neighbors_on_route(StopIt left_id, StopIt right_id) const;
-	bool can_be_compressed(StopIt left_id, StopIt right_id) const;
+	/*Stops that are neighbours on some route can't share a map index*/
+	void collect_route_neighbours();
+	bool can_be_compressed(StopId left, StopId right) const;
+
+	/*Deltas: the map is laid out again, the layers are redrawn only if something moved*/
+	void update_map_layout(bool are_routes_changed);
+	void invalidate_layers(std::initializer_list<std::string_view> layers);
 	
 
 	void compress_coordinates_in_place(
-		std::vector<StopHandleIt>* storage,
-		std::function<bool(StopIt left, StopIt right)> pred,
+		std::vector<StopId>* storage,
+		std::function<bool(StopId left, StopId right)> pred,
 		std::function<void(MapIndex*, size_t)> visitor
 	);
 
@@ -237,31 +471,29 @@ private:
 	void print_stops(svg::Document* doc) const;
 	void draw_stop(
 		svg::Document* doc, 
-		const StopHolder& stop
+		StopId stop
 	) const;
 
 	void print_stop_labels(svg::Document* doc) const;
 	void draw_stop_label(
 		svg::Document* doc, 
-		StopId stop_id,
-		const StopHolder& stop_info
+		StopId stop
 	) const;
 	void emplace_stop_label_on_map(
 		svg::Document* doc,
-		StopId stop_id,
+		std::string_view stop_name,
 		svg::Point point
 	)  const;
 
 	void print_bus_labels(svg::Document* doc) const;
 	void draw_bus_label(
 		svg::Document* doc, 
-		BusId bus_id, 
-		const BusHolder& bus_info, 
+		BusId bus, 
 		const svg::Color& color
 	) const;
 	void emplace_bus_label_on_map(
 		svg::Document* doc,
-		BusId bus_id,
+		std::string_view bus_name,
 		svg::Point point,
 		const svg::Color& color
 	)  const;
@@ -269,7 +501,7 @@ private:
 	void print_bus_routes(svg::Document* doc) const;
 	void draw_route(
 		svg::Document* doc, 
-		const BusHolder& bus, 
+		BusId bus, 
 		const svg::Color& color
 	) const;
 
@@ -283,27 +515,62 @@ private:
 
 #endif
 private:
+#ifdef MULTITHREADING
+	/*Each thread appends to its own buffer, the buffers are merged at Synchronize*/
+	algo::execution::PerThread<Staging> staging;
+#else
+	Staging staging;
+#endif
+
 	/*Databases*/
-	StopsDatabase stops;
-	BusDatabase buses;
+	StopsTable stops;
+	BusesTable buses;
+	NameIndex<StopId> stop_ids;
+	NameIndex<BusId> bus_ids;
+	std::unordered_map<std::string_view, StopId> added_stop_ids;
+	std::unordered_map<std::string_view, BusId> added_bus_ids;
+
+	/*Answer revisions: stamped from a single counter, so they never repeat*/
+	std::vector<uint64_t> stop_revisions;
+	std::vector<uint64_t> bus_revisions;
+	uint64_t last_revision{ 0 };
+
+	/*Distances to the stops that aren't in the database yet: stop name -> (from, distance)*/
+	std::unordered_map<std::string_view, RoadDistances> pending_road_distances;
+	std::unordered_map<StopId, std::vector<std::string_view>> pending_neighbours;	//from -> stop names
+	Garbage garbage;
+	Compactions compactions;
+
+	/*Synchronize stages timing*/
+	std::array<std::chrono::nanoseconds, SYNC_STAGE_COUNT> sync_timings{};
 
 	/*Navigation*/
 	std::unique_ptr<routing::Parameters> routing_settings;
 	TransportGraphHolder graph;
 	NavigatorHolder navigator;
 
+	/*Lazy graph update: the deltas only set the changes, the first search after them applies the batch*/
+	mutable TransportGraphBuilderHolder graph_builder;					//Only while a batch is pending: refrozen and dropped at the flush
+	mutable GraphChanges graph_changes;
+	mutable Graph::Components components;								//Unreachable pairs are answered without the navigator
+#ifdef MULTITHREADING
+	mutable std::mutex graph_flush_mutex;								//The searches run concurrently
+	mutable std::atomic<bool> has_graph_changes{ false };
+#else
+	mutable bool has_graph_changes{ false };
+#endif
+
+	/*The loaded snapshot (the names refer to it)*/
+	std::unique_ptr<snapshot::Reader> snapshot_file;
+
 #ifdef RENDER
 	/*2D Graphics*/
 	std::unique_ptr<render::Settings> render_settings;
 	std::unique_ptr<Step> step_info;
+	std::unordered_set<uint64_t> route_neighbours;						//Unordered pairs of stops
+	mutable std::vector<std::optional<svg::Document>> layer_cache;		//Layers in the order of layer_sequence
 	mutable std::unique_ptr<svg::Document> render_cache;
 #endif
-
-#ifdef MULTITHREADING
-private:
-	/*Thread guards*/
-	mutable std::mutex stops_mtx, buses_mtx;
-#endif
 };
 
 #ifdef RENDER
@@ -320,9 +587,23 @@ svg::Polyline TransportCatalog::create_route_polyline(
 		.SetStrokeColor(color)
 		.SetStrokeWidth(render_settings->route.line_width);
 	for (; first != last; ++first) {
-		const svg::Point stop_on_map{ scale_coordinates(stops.at(*first).index_on_map) };
+		const svg::Point stop_on_map{ scale_coordinates(stops.map_indices[*first]) };
 		route_polyline.AddPoint(stop_on_map);
 	}
 	return route_polyline;
 }
+#endif
+
+#ifdef MULTITHREADING
+template <class Id, class Function>
+algo::execution::Task<void> TransportCatalog::for_each_id(size_t id_count, Function func) {
+	const auto ids{ std::views::iota(Id{ 0 }, static_cast<Id>(id_count)) };
+	co_await algo::execution::async_for(ids.begin(), ids.end(), std::move(func));
+}
+
+template <class Function>
+algo::execution::Task<void> TransportCatalog::run_on_pool(Function func) {
+	co_await algo::execution::schedule_on(algo::execution::default_pool());
+	func();
+}
 #endif
\ No newline at end of file
@@ -7,7 +7,30 @@ using request::IFactory;
 using routing::Parameters;
 using namespace std;
 
-const Json::Node& GetBranch(const Json::Document& doc, const std::string& section) {
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument{ argv[i] };
+        if (argument == "--save-snapshot" || argument == "--load-snapshot") {
+            if (i + 1 == argc) {
+                throw invalid_argument("Missing snapshot path after " + string(argument));
+            }
+            (argument == "--save-snapshot" ? options.save_snapshot : options.load_snapshot) = argv[++i];
+        }
+        else if (!argument.starts_with("--") && !options.input) {
+            options.input = argument;
+        }
+        else {
+            throw invalid_argument("Unexpected argument " + string(argument));
+        }
+    }
+    if (options.save_snapshot && options.load_snapshot) {
+        throw invalid_argument("--save-snapshot and --load-snapshot are exclusive");
+    }
+    return options;
+}
+
+const Json::Node& GetBranch(const Json::Document& doc, std::string_view section) {
     return doc.GetRoot().AsMap().at(section);
 }
 
@@ -35,23 +58,24 @@ render::Settings ExtractRenderSettings(const Json::Document& doc) {
 #endif
 
 #ifdef MULTITHREADING
-vector<HandlerHolder> MakeHandlers(IFactory* factory, const vector<Node>& raw_requests) {
-    Synchronized<vector<HandlerHolder>> handlers;
+vector<HandlerHolder> MakeHandlers(IFactory* factory, const Json::array_t& raw_requests) {
+    vector<HandlerHolder> handlers(raw_requests.size());        //Each worker fills only the slots of its requests
     algo::execution::parallel_for(
         raw_requests.begin(),
         raw_requests.end(),
-        [factory, &handlers](const Node& node) {
-            auto handler{ factory->Create(node) };
-            handlers.GetAccess().ref_to_value.push_back(move(handler));
+        [factory, &handlers, first = raw_requests.data()](const Node& node) {
+            const size_t position{ static_cast<size_t>(addressof(node) - first) };
+            handlers[position] = factory->Create(node, position);
         }
     );
-    return move(handlers.GetAccess().ref_to_value);     //We create vector<HandlerHolder> here
+    return handlers;
 }
 #else
-vector<HandlerHolder> MakeHandlers(IFactory* factory, const vector<Node>& raw_requests) {
+vector<HandlerHolder> MakeHandlers(IFactory* factory, const Json::array_t& raw_requests) {
     vector<HandlerHolder> handlers;
+    handlers.reserve(raw_requests.size());
     for (const auto& node : raw_requests) {
-        handlers.push_back(factory->Create(node));
+        handlers.push_back(factory->Create(node, handlers.size()));
     }
     return handlers;
 }
@@ -59,7 +83,7 @@ vector<HandlerHolder> MakeHandlers(IFactory* factory, const vector<Node>& raw_re
 
 #ifdef MULTITHREADING
 void ProcessRequests(vector<request::HandlerHolder>& handlers) {
-    algo::execution::parallel_for(
+    algo::execution::dynamic_for(       //Route requests are much more expensive than Bus and Stop ones
         handlers.begin(),
         handlers.end(),
         [](request::HandlerHolder& handler) {
@@ -74,10 +98,50 @@ void ProcessRequests(vector<request::HandlerHolder>& handlers) {
 }
 #endif
 
-string SerializeResult(const request::Read::Storage& result) {
 #ifdef MULTITHREADING
-    return Json::Serialize(Json::Document(Json::Node(result.GetAccess().ref_to_value)));
-#else
-    return Json::Serialize(Json::Document(Json::Node(result)));
+algo::execution::Task<void> SynchronizeCatalog(TransportCatalog& tr_catalog) {
+    co_await algo::execution::schedule_on(algo::execution::default_pool());
+    co_await tr_catalog.SynchronizeAsync();
+}
+
+algo::execution::Task<void> MakeHandlersAsync(IFactory* factory, const Json::array_t& raw_requests, vector<HandlerHolder>& handlers) {
+    co_await algo::execution::async_for(
+        raw_requests.begin(),
+        raw_requests.end(),
+        [factory, &handlers, first = raw_requests.data()](const Node& node) {
+            const size_t position{ static_cast<size_t>(addressof(node) - first) };
+            handlers[position] = factory->Create(node, position);
+        }
+    );
+}
+
+algo::execution::Task<void> AnswerRequests(
+    IFactory* factory,
+    const Json::array_t& raw_requests,
+    TransportCatalog& tr_catalog,
+    request::AnswerCache* answers
+) {
+    vector<HandlerHolder> handlers(raw_requests.size());
+
+    vector<algo::execution::Task<void>> stages;
+    if (!tr_catalog.IsSynchronized()) {
+        stages.push_back(SynchronizeCatalog(tr_catalog));
+    }
+    stages.push_back(MakeHandlersAsync(factory, raw_requests, handlers));
+    co_await algo::execution::when_all(move(stages));
+    if (answers) {
+        co_await answers->BuildAsync(tr_catalog);
+    }
+
+    co_await algo::execution::async_for(
+        handlers.begin(),
+        handlers.end(),
+        [](HandlerHolder& handler) {
+            handler->Process();
+        });
+}
 #endif
-}
\ No newline at end of file
+
+void SerializeResult(const request::Read::Storage& result, ostream& output, Json::Format format) {
+    Json::Writer(output, format).Write(result);
+}
@@ -4,12 +4,17 @@
 
 /*JSON serialization and deserialization*/
 #include "json.h"
+#include "json_source.h"
 
 /*Transport catalog engine*/
 #include "transport_catalog.h"
 
 /*Requests handling*/
 #include "request.h"
+#include "answer_cache.h"
+#ifdef STREAMING
+#include "ingestion.h"
+#endif
 
 #ifdef RENDER
 /*2D vector graphical primitives and settings*/
@@ -20,20 +25,44 @@
 /*Standart headers*/
 #include <vector>
 #include <tuple>
+#include <ostream>
+#include <optional>
+#include <string>
+
+/*Command line: TransportCatalog [--save-snapshot <path> | --load-snapshot <path>] [input file]*/
+struct Options {
+    std::optional<std::string> input;               //The standard input if not set
+    std::optional<std::string> save_snapshot;       //The synchronized catalog is saved after the answers
+    std::optional<std::string> load_snapshot;       //Replaces base_requests and routing_settings of the input
+};
+
+Options ParseOptions(int argc, char* argv[]);       //Throws std::invalid_argument
 
 std::vector<request::HandlerHolder> MakeHandlers(
     request::IFactory* factory, 
-    const std::vector<Json::Node>& raw_requests
+    const Json::array_t& raw_requests
 );
 
 void ProcessRequests(std::vector<request::HandlerHolder>& handlers);
+
+#ifdef MULTITHREADING
+/*Stat requests are parsed while the catalog is being synchronized (unless it is loaded from a snapshot), then processed.
+All stages are tasks on the shared pool: waiting stages are suspended instead of blocking threads.
+The answer cache (if any) is built between the synchronization and the processing*/
+algo::execution::Task<void> AnswerRequests(
+    request::IFactory* factory,
+    const Json::array_t& raw_requests,
+    TransportCatalog& tr_catalog,
+    request::AnswerCache* answers = nullptr
+);
+#endif
 routing::Parameters ExtractRoadSettings(const Json::Document& doc);
 
 #ifdef RENDER
 render::Settings ExtractRenderSettings(const Json::Document& doc);
 #endif
 
-const Json::Node& GetBranch(const Json::Document& doc, const std::string& section);
+const Json::Node& GetBranch(const Json::Document& doc, std::string_view section);
 
 inline decltype(auto) SplitByCategories(const Json::Document& doc) {       //Without inline we get an ODR error
     return std::tie(
@@ -42,5 +71,6 @@ inline decltype(auto) SplitByCategories(const Json::Document& doc) {       //Wit
     );
 }
 
-std::string SerializeResult(const request::Read::Storage& result);
+/*Writes the answers directly to the stream*/
+void SerializeResult(const request::Read::Storage& result, std::ostream& output, Json::Format format = Json::Format::PRETTY);
 